@@ -19,12 +19,18 @@
 #include <linux/gpio/consumer.h>
 #include <linux/interrupt.h>
 #include <linux/fs.h>
+#include <linux/ktime.h>
+#include <linux/wait.h>
 
 
 #define VL53L8CX_COMMS_CHUNK_SIZE 1024
 
 #define ST_TOF_IOCTL_TRANSFER 		_IOWR('a',0x1, struct stmvl53l8cx_comms_struct)
 #define ST_TOF_IOCTL_WAIT_FOR_INTERRUPT	_IO('a',0x2)
+#define ST_TOF_IOCTL_TRANSFER_BATCH	_IOW('a',0x3, struct stmvl53l8cx_batch_struct)
+#define ST_TOF_IOCTL_WAIT_FOR_INTERRUPT_DEADLINE	_IOW('a',0x4, struct stmvl53l8cx_wait_deadline_struct)
+
+#define VL53L8CX_MAX_BATCH_TRANSFERS	256
 
 
 struct stmvl53l8cx_drvdata {
@@ -46,6 +52,16 @@ struct stmvl53l8cx_comms_struct {
 	__u64   bufptr;
 };
 
+struct stmvl53l8cx_batch_struct {
+	__u32   nb_transfers;
+	__u32   padding; /* 64bits alignment */
+	__u64   transfers; /* array of stmvl53l8cx_comms_struct */
+};
+
+struct stmvl53l8cx_wait_deadline_struct {
+	__u64   deadline_ns; /* absolute CLOCK_MONOTONIC time */
+};
+
 static int stmvl53l8cx_i2c_read(struct stmvl53l8cx_drvdata *drvdata, uint32_t count)
 {
 	int ret = 0;
@@ -275,12 +291,41 @@ static int stmvl53l8cx_read_write(struct stmvl53l8cx_drvdata *drvdata, uint16_t
 	return ret;
 }
 
+/* Run the transfers of a batch in order, stopping at the first error */
+static int stmvl53l8cx_transfer_batch(struct stmvl53l8cx_drvdata *drvdata,
+							 struct stmvl53l8cx_batch_struct *batch)
+{
+	int ret = 0;
+	uint32_t i;
+	struct stmvl53l8cx_comms_struct comms_struct;
+	struct stmvl53l8cx_comms_struct __user *transfers =
+		(struct stmvl53l8cx_comms_struct __user *)(uintptr_t)batch->transfers;
+
+	for (i = 0; i < batch->nb_transfers; i++) {
+		if (copy_from_user(&comms_struct, &transfers[i], sizeof(comms_struct))) {
+			pr_err("%s:%d transfer %u\n", __func__, __LINE__, i);
+			return -EFAULT;
+		}
+		ret = stmvl53l8cx_read_write(drvdata, comms_struct.reg_index,
+							(char __user *)(uintptr_t)comms_struct.bufptr,
+							comms_struct.len, comms_struct.write_not_read);
+		if (ret) {
+			pr_err("%s:%d transfer %u err[%d]\n", __func__, __LINE__, i, ret);
+			return -EIO;
+		}
+	}
+	return 0;
+}
+
 static long stmvl53l8cx_ioctl(struct file *file, unsigned int cmd, unsigned long arg)
 {
 	int ret = 0;
 	struct stmvl53l8cx_drvdata *drvdata = container_of(file->private_data, 
     										struct stmvl53l8cx_drvdata, misc);
 	struct stmvl53l8cx_comms_struct comms_struct = {0};
+	struct stmvl53l8cx_batch_struct batch_struct = {0};
+	struct stmvl53l8cx_wait_deadline_struct wait_struct = {0};
+	ktime_t timeout;
 	void __user *data_ptr = NULL;
 
 	pr_debug("stmvl53l8cx_ioctl : cmd = %u\n", cmd);
@@ -294,6 +339,22 @@ static long stmvl53l8cx_ioctl(struct file *file, unsigned int cmd, unsigned long
 				return -EINTR;
 			}
 			break;
+		case ST_TOF_IOCTL_WAIT_FOR_INTERRUPT_DEADLINE:
+			if (copy_from_user(&wait_struct, (void __user *)arg, sizeof(wait_struct)))
+				return -EFAULT;
+			timeout = ktime_sub(ns_to_ktime(wait_struct.deadline_ns), ktime_get());
+			if (ktime_to_ns(timeout) < 0)
+				timeout = 0;
+			ret = wait_event_interruptible_hrtimeout(drvdata->wq,
+					atomic_read(&drvdata->intr_ready_flag) != 0, timeout);
+			if (ret == -ETIME)
+				return -ETIMEDOUT;
+			if (ret) {
+				pr_info("%s: wait_event_interruptible_hrtimeout err=%d\n", __func__, ret);
+				return -EINTR;
+			}
+			atomic_set(&drvdata->intr_ready_flag, 0);
+			break;
 		case ST_TOF_IOCTL_TRANSFER:
 			ret = copy_from_user(&comms_struct, (void __user *)arg, sizeof(comms_struct));
 			if (ret) {
@@ -315,6 +376,16 @@ static long stmvl53l8cx_ioctl(struct file *file, unsigned int cmd, unsigned long
 				return -EFAULT;
 			}
 			break;
+		case ST_TOF_IOCTL_TRANSFER_BATCH:
+			if (copy_from_user(&batch_struct, (void __user *)arg, sizeof(batch_struct)))
+				return -EFAULT;
+			if (batch_struct.nb_transfers > VL53L8CX_MAX_BATCH_TRANSFERS)
+				return -E2BIG;
+			pr_debug("batch of %u transfers\n", batch_struct.nb_transfers);
+			ret = stmvl53l8cx_transfer_batch(drvdata, &batch_struct);
+			if (ret)
+				return ret;
+			break;
 
 		default:
 			return -EINVAL;
@@ -105,6 +105,11 @@ int example2(VL53L8CX_Configuration *p_dev)
 	}
 	printf("Current integration time is : %d ms\n", integration_time_ms);
 
+	/* (Optional) Time taken by the firmware to answer the commands */
+	printf("Firmware answer time : last %u us, max %u us\n",
+			(unsigned int)p_dev->last_answer_time_us,
+			(unsigned int)p_dev->max_answer_time_us);
+
 
 	/*********************************/
 	/*         Ranging loop          */
@@ -31,6 +31,7 @@ int example5(VL53L8CX_Configuration *p_dev)
 	/*********************************/
 
 	uint8_t 				status, loop, isAlive, isReady, i, j;
+	uint8_t 				nb_target_per_zone;
 	VL53L8CX_ResultsData 	Results;		/* Results data from VL53L8CX */
 
 	
@@ -64,9 +65,14 @@ int example5(VL53L8CX_Configuration *p_dev)
 
 	/* Each zone can output between 1 and 4 targets. By default the output
 	 * is set to 1 targets, but user can change it using macro
-	 * VL53L8CX_NB_TARGET_PER_ZONE located in file 'platform.h'.
+	 * VL53L8CX_NB_TARGET_PER_ZONE located in file 'platform.h'. This macro
+	 * is the maximum, a lower number can be set for each device using
+	 * function vl53l8cx_set_nb_target_per_zone(). The results of a zone are
+	 * then nb_target_per_zone entries apart.
 	 */
 
+	status = vl53l8cx_get_nb_target_per_zone(p_dev, &nb_target_per_zone);
+
 	/*********************************/
 	/*         Ranging loop          */
 	/*********************************/
@@ -98,10 +104,10 @@ int example5(VL53L8CX_Configuration *p_dev)
 					(int)Results.ambient_per_spad[i],
 					(int)Results.nb_spads_enabled[i]);
 
-				for(j = 0; j < VL53L8CX_NB_TARGET_PER_ZONE; j++)
+				for(j = 0; j < nb_target_per_zone; j++)
 				{
 					/* Print per target results. These results depends of the target nb */
-					uint16_t idx = VL53L8CX_NB_TARGET_PER_ZONE * i + j;
+					uint16_t idx = nb_target_per_zone * i + j;
 					printf("Target[%1u] : %2u, %4d, %6d, %3u, ",
 						j,
 						Results.target_status[idx],
@@ -79,8 +79,16 @@ int example6(VL53L8CX_Configuration *p_dev)
 	 * #define VL53L8CX_DISABLE_RANGE_SIGMA_MM
 	 * #define VL53L8CX_DISABLE_REFLECTANCE_PERCENT
 	 * #define VL53L8CX_DISABLE_MOTION_INDICATOR
+	 *
+	 * The outputs sent through I2C can also be selected at runtime for each
+	 * device, among the ones not disabled, before starting the ranging.
+	 * The RAM footprint is not reduced.
 	 */
 
+	status = vl53l8cx_set_outputs(p_dev, VL53L8CX_OUTPUTS_AVAILABLE
+		& (VL53L8CX_OUTPUT_DISTANCE_MM | VL53L8CX_OUTPUT_TARGET_STATUS
+		| VL53L8CX_OUTPUT_NB_TARGET_DETECTED));
+
 	/*********************************/
 	/*         Ranging loop          */
 	/*********************************/
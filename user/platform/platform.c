@@ -12,13 +12,12 @@
 
 #include <fcntl.h> // open()
 #include <unistd.h> // close()
+#include <errno.h>
+#include <stddef.h> // offsetof()
 #include <time.h> // clock_gettime()
 
-#include <linux/i2c.h>
-#include <linux/i2c-dev.h>
-#ifdef SPI
-#include <linux/spi/spidev.h>
-#endif
+#include <linux/gpio.h>
+#include <poll.h>
 
 #include <sys/ioctl.h>
 
@@ -33,276 +32,222 @@
 #define SUPPRESS_UNUSED_WARNING(x) \
 	((void) (x))
 
-#define VL53L8CX_COMMS_CHUNK_SIZE  1024
-
-#ifdef SPI
-#define VL53L8_SPIDEV_CHUNK_SIZE   4096 - 2 // 4096 is the SPIDEV limit, 2 for register index
-			 
-#define VL53L8CX_SPI_MODE  SPI_MODE_0
-#define VL53L8CX_SPI_SPEED_HZ  2000000
-#define VL53L8CX_SPI_NB_BITS   8
-#endif									  
+#define VL53L8CX_PAGE_REGISTER     0x7fff
 
 #define LOG 				printf
 
-#ifdef STMVL53L8CX_KERNEL
+#define VL53L8CX_GPIO_CONSUMER		"vl53l8cx"
+#define VL53L8CX_GPIO_EVENTS_PER_READ	16
 
-struct comms_struct {
-	uint16_t   len;
-	uint16_t   reg_address;
-	uint8_t    write_not_read;
-	uint8_t    padding[3]; /* 64bits alignment */
-	uint64_t   bufptr;
-};
+/*
+ * Request the INT line with falling edge events (INT is active low). On
+ * failure gpio_fd stays at -1 and data ready is polled.
+ */
+static void GPIO_Init(VL53L8CX_Platform *p_platform)
+{
+	struct gpio_v2_line_request req;
+	int chip_fd;
 
-#elif SPI
-	static int32_t Linux_SPI_Read_16M(int fd, uint16_t index, uint8_t* read_data, uint32_t read_size, uint32_t speed_hz);
-	static int32_t Linux_SPI_Write_16M(int fd, uint16_t index, uint8_t* write_data, uint32_t write_size, uint32_t speed_hz);					 
-#else
-	static uint8_t i2c_buffer[VL53L8CX_COMMS_CHUNK_SIZE];
-#endif
+	p_platform->gpio_fd = -1;
+	if (p_platform->gpio_chip[0] == '\0')
+		return;
 
-#define ST_TOF_IOCTL_TRANSFER           _IOWR('a',0x1, struct comms_struct)
-#define ST_TOF_IOCTL_WAIT_FOR_INTERRUPT	_IO('a',0x2)
+	chip_fd = open(p_platform->gpio_chip, O_RDWR | O_CLOEXEC);
+	if (chip_fd == -1) {
+		LOG("Failed to open %s, polling data ready\n", p_platform->gpio_chip);
+		return;
+	}
 
+	memset(&req, 0, sizeof(req));
+	req.offsets[0] = p_platform->gpio_line;
+	req.num_lines = 1;
+	req.config.flags = GPIO_V2_LINE_FLAG_INPUT | GPIO_V2_LINE_FLAG_EDGE_FALLING;
+	strncpy(req.consumer, VL53L8CX_GPIO_CONSUMER, sizeof(req.consumer) - 1);
 
-	
+	if (ioctl(chip_fd, GPIO_V2_GET_LINE_IOCTL, &req) < 0)
+		LOG("Could not request line %u of %s, polling data ready\n",
+			p_platform->gpio_line, p_platform->gpio_chip);
+	else {
+		p_platform->gpio_fd = req.fd;
+		LOG("INT on %s line %u\n", p_platform->gpio_chip, p_platform->gpio_line);
+	}
+	close(chip_fd);
+}
 
-int32_t vl53l8cx_comms_init(VL53L8CX_Platform * p_platform)
+/*
+ * Wait for at least one edge on the INT line and drain the queued events.
+ * Returns 1 on edge, 0 on timeout and -1 on error.
+ */
+static int32_t GPIO_WaitEdge(VL53L8CX_Platform *p_platform, int timeout_ms)
 {
+	struct gpio_v2_line_event events[VL53L8CX_GPIO_EVENTS_PER_READ];
+	struct pollfd pfd;
+	int ret;
 
-#ifdef STMVL53L8CX_KERNEL
-	p_platform->fd = open("/dev/stmvl53l8cx", O_RDONLY);
-	if (p_platform->fd == -1) {
-		LOG("Failed to open /dev/stmvl53l8cx\n");
-		return VL53L8CX_COMMS_ERROR;
-	}
-#elif SPI
-	uint8_t spi_mode = VL53L8CX_SPI_MODE;
-	uint8_t bits = VL53L8CX_SPI_NB_BITS;
-	uint32_t speed = VL53L8CX_SPI_SPEED_HZ;
-	char devname[32];
-	
-	sprintf(devname, "/dev/spidev%d.%d", p_platform->spi_num, p_platform->spi_cs);
-	p_platform->fd = open(devname, O_RDWR);
-	if (p_platform->fd == -1) {
-		LOG("Failed to open %s\n", devname);
-		return VL53L8CX_COMMS_ERROR;
-	}
-	else
-		LOG("Opened SPI %s\n", devname);
+	pfd.fd = p_platform->gpio_fd;
+	pfd.events = POLLIN;
+	pfd.revents = 0;
 
-	if (ioctl(p_platform->fd, SPI_IOC_WR_MODE, &spi_mode) <0) {
-		LOG("Could not program clock phase and polarity (WR)\n");
-		return VL53L8CX_COMMS_ERROR;
-	}
+	do {
+		ret = poll(&pfd, 1, timeout_ms);
+	} while ((ret < 0) && (errno == EINTR));
 
-	if (ioctl(p_platform->fd, SPI_IOC_RD_MODE, &spi_mode) <0) {
-		LOG("Could not program clock phase and polarity (RD)\n");
-		return VL53L8CX_COMMS_ERROR;
-	}
+	if (ret <= 0)
+		return ret;
 
-	if (ioctl(p_platform->fd, SPI_IOC_WR_BITS_PER_WORD, &bits) <0) {
-		LOG("Could not program bits per words (WR)\n");
-		return VL53L8CX_COMMS_ERROR;
-	}
+	if (read(p_platform->gpio_fd, events, sizeof(events)) < (ssize_t)sizeof(events[0]))
+		return -1;
 
-	if (ioctl(p_platform->fd, SPI_IOC_RD_BITS_PER_WORD, &bits) <0) {
-		LOG("Could not program bits per words (RD)\n");
-		return VL53L8CX_COMMS_ERROR;
-	}
+	return 1;
+}
 
-	if (ioctl(p_platform->fd, SPI_IOC_WR_MAX_SPEED_HZ, &speed) <0) {
-		LOG("Could not program speed (WR)\n");
-		return VL53L8CX_COMMS_ERROR;
-	}
+uint64_t VL53L8CX_ClockTimeUs(void)
+{
+	struct timespec ts;
 
-	if (ioctl(p_platform->fd, SPI_IOC_RD_MAX_SPEED_HZ, &speed) <0) {
-		LOG("Could not program speed (RD)\n");
-		return VL53L8CX_COMMS_ERROR;
-	}
-#else	
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ((uint64_t)ts.tv_sec * 1000000) + ((uint64_t)ts.tv_nsec / 1000);
+}
 
-	/* Create sensor at default i2c address */
-	p_platform->address = 0x52;
-	p_platform->fd = open("/dev/i2c-1", O_RDONLY);
-	if (p_platform->fd == -1) {
-		LOG("Failed to open /dev/i2c-1\n");
+int32_t vl53l8cx_comms_init(VL53L8CX_Platform * p_platform)
+{
+	int32_t status;
+
+	p_platform->tr_active = 0;
+	p_platform->tr_status = 0;
+	p_platform->tr_nb_accesses = 0;
+	p_platform->tr_data_size = 0;
+	VL53L8CX_InvalidatePage(p_platform);
+	p_platform->gpio_fd = -1;
+	VL53L8CX_ResetStats(p_platform);
+
+	if (p_platform->transport == NULL)
+		p_platform->transport = VL53L8CX_DEFAULT_TRANSPORT;
+
+	/* The INT line is only waited when the transport has no interrupt: a
+	 * bus trace would not record its edges */
+	if ((p_platform->gpio_chip[0] != '\0')
+		&& (p_platform->transport->wait_interrupt != NULL)) {
+		LOG("INT on %s is not supported with the %s transport\n",
+			p_platform->gpio_chip, p_platform->transport->name);
 		return VL53L8CX_COMMS_ERROR;
 	}
 
-	if (ioctl(p_platform->fd, I2C_SLAVE, p_platform->address) <0) {
-		LOG("Could not speak to the device on the i2c bus\n");
-		return VL53L8CX_COMMS_ERROR;
-	}
-#endif	  
+	status = p_platform->transport->open(p_platform);
+	if (status != 0)
+		return status;
 
+	if (p_platform->transport->wait_interrupt == NULL)
+		GPIO_Init(p_platform);
 
-	LOG("Opened ST TOF Dev = %d\n", p_platform->fd);
+	LOG("Opened ST TOF Dev = %d (%s)\n", p_platform->fd, p_platform->transport->name);
 
 	return 0;
 }
 
 int32_t vl53l8cx_comms_close(VL53L8CX_Platform * p_platform)
 {
-	close(p_platform->fd);
+	p_platform->transport->close(p_platform);
+	if (p_platform->gpio_fd >= 0)
+		close(p_platform->gpio_fd);
+	p_platform->gpio_fd = -1;
 	return 0;
 }
 
+/*
+ * Send the accesses queued by the current transaction
+ */
+static int32_t comms_flush_transaction(VL53L8CX_Platform * p_platform)
+{
+	int32_t status = 0;
+
+	if (p_platform->tr_nb_accesses > 0)
+		status = p_platform->transport->submit(p_platform,
+				p_platform->tr_accesses, p_platform->tr_nb_accesses);
+
+	p_platform->tr_nb_accesses = 0;
+	p_platform->tr_data_size = 0;
+	if (status != 0) {
+		p_platform->tr_status = 1;
+		VL53L8CX_InvalidatePage(p_platform);
+	}
+
+	return status;
+}
+
 int32_t write_read_multi(
-		int fd,
-		uint16_t i2c_address,
+		VL53L8CX_Platform * p_platform,
 		uint16_t reg_address,
 		uint8_t *pdata,
 		uint32_t count,
 		int write_not_read)
 {
-#ifdef STMVL53L8CX_KERNEL
-	struct comms_struct cs;
+	VL53L8CX_Access *access;
 
-	cs.len = count;
-	cs.reg_address = reg_address;
-	cs.bufptr = (uint64_t)(uintptr_t)pdata;
-	cs.write_not_read = write_not_read;
-
-	if (ioctl(fd, ST_TOF_IOCTL_TRANSFER, &cs) < 0)
-		return VL53L8CX_COMMS_ERROR;
-	
-#elif SPI
+	if (count == 0)
+		return 0;
 
-	int32_t status = 0;
-	uint32_t data_size = 0;
-	uint32_t position = 0;
+	if (!p_platform->tr_active) {
+		VL53L8CX_Access single = {reg_address, (uint8_t)write_not_read, count, pdata};
 
-	if (write_not_read) {
-	  
-		for (position = 0; position < count; position += VL53L8_SPIDEV_CHUNK_SIZE) {
-			if (count > VL53L8_SPIDEV_CHUNK_SIZE) {
-				if ((position + VL53L8_SPIDEV_CHUNK_SIZE) > count)
-
-												 
-					data_size = count - position;
-				else
-					data_size = VL53L8_SPIDEV_CHUNK_SIZE;
-			} else {
-				data_size = count;
-			}
-			if (Linux_SPI_Write_16M(fd, reg_address + position, pdata + position, data_size, VL53L8CX_SPI_SPEED_HZ) != 0) {
-				LOG("vl53l8_write_multi Linux_SPI_Write_16M() failed\n");
-					 									 
-				status = VL53L8CX_COMMS_ERROR;
-				goto exit;
-			}
-		}
+		return p_platform->transport->submit(p_platform, &single, 1);
 	}
 
-	else {
-		for (position = 0; position < count; position +=
-				VL53L8_SPIDEV_CHUNK_SIZE) {
-			if (count > VL53L8_SPIDEV_CHUNK_SIZE) {
-				if ((position + VL53L8_SPIDEV_CHUNK_SIZE) > count)
-					data_size = count - position;
-				else
-					data_size = VL53L8_SPIDEV_CHUNK_SIZE;
-			} else {
-				data_size = count;
-			}
-			if (Linux_SPI_Read_16M(fd, reg_address + position, pdata + position, data_size, VL53L8CX_SPI_SPEED_HZ) != 0) {
-				LOG("vl53l8_read_multi: Linux_SPI_Read_16M() failed\n");
-									 
-				status = VL53L8CX_COMMS_ERROR;
-				goto exit;
-			}
-
-		}
+	if (p_platform->tr_nb_accesses == VL53L8CX_TR_MAX_ACCESSES) {
+		if (comms_flush_transaction(p_platform) != 0)
+			return VL53L8CX_COMMS_ERROR;
 	}
-	
-	exit:
-		return status;
-
-
-#else
-
-	struct i2c_rdwr_ioctl_data packets;
-	struct i2c_msg messages[2];
-
-	uint32_t data_size = 0;
-	uint32_t position = 0;
 
 	if (write_not_read) {
-		do {
-			data_size = (count - position) > (VL53L8CX_COMMS_CHUNK_SIZE-2) ? (VL53L8CX_COMMS_CHUNK_SIZE-2) : (count - position);
-
-			memcpy(&i2c_buffer[2], &pdata[position], data_size);
-
-			i2c_buffer[0] = (reg_address + position) >> 8;
-			i2c_buffer[1] = (reg_address + position) & 0xFF;
-
-			messages[0].addr = i2c_address >> 1;
-			messages[0].flags = 0; //I2C_M_WR;
-			messages[0].len = data_size + 2;
-			messages[0].buf = i2c_buffer;
-
-			packets.msgs = messages;
-			packets.nmsgs = 1;
-
-			if (ioctl(fd, I2C_RDWR, &packets) < 0)
+		if (count > VL53L8CX_TR_DATA_SIZE) {
+			/* Too large to be copied: keep the order and send it now */
+			if (comms_flush_transaction(p_platform) != 0)
 				return VL53L8CX_COMMS_ERROR;
-			position +=  data_size;
-
-		} while (position < count);
-	}
-
-	else {
-		do {
-			data_size = (count - position) > VL53L8CX_COMMS_CHUNK_SIZE ? VL53L8CX_COMMS_CHUNK_SIZE : (count - position);
-
-			i2c_buffer[0] = (reg_address + position) >> 8;
-			i2c_buffer[1] = (reg_address + position) & 0xFF;
-
-			messages[0].addr = i2c_address >> 1;
-			messages[0].flags = 0; //I2C_M_WR;
-			messages[0].len = 2;
-			messages[0].buf = i2c_buffer;
-
-			messages[1].addr = i2c_address >> 1;
-			messages[1].flags = I2C_M_RD;
-			messages[1].len = data_size;
-			messages[1].buf = pdata + position;
-
-			packets.msgs = messages;
-			packets.nmsgs = 2;
+			access = &p_platform->tr_accesses[0];
+			access->reg_address = reg_address;
+			access->write_not_read = 1;
+			access->count = count;
+			access->p_data = pdata;
+			p_platform->tr_nb_accesses = 1;
+			return comms_flush_transaction(p_platform);
+		}
 
-			if (ioctl(fd, I2C_RDWR, &packets) < 0)
+		if (p_platform->tr_data_size + count > VL53L8CX_TR_DATA_SIZE) {
+			if (comms_flush_transaction(p_platform) != 0)
 				return VL53L8CX_COMMS_ERROR;
+		}
 
-			position += data_size;
-
-		} while (position < count);
+		memcpy(&p_platform->tr_data[p_platform->tr_data_size], pdata, count);
+		pdata = &p_platform->tr_data[p_platform->tr_data_size];
+		p_platform->tr_data_size += count;
 	}
 
-#endif
+	/* Read data lands in the caller buffer at commit */
+	access = &p_platform->tr_accesses[p_platform->tr_nb_accesses++];
+	access->reg_address = reg_address;
+	access->write_not_read = (uint8_t)write_not_read;
+	access->count = count;
+	access->p_data = pdata;
+
 	return 0;
 }
 
 int32_t write_multi(
-		int fd,
-		uint16_t i2c_address,
+		VL53L8CX_Platform * p_platform,
 		uint16_t reg_address,
 		uint8_t *pdata,
 		uint32_t count)
 {
-	return(write_read_multi(fd, i2c_address, reg_address, pdata, count, 1));
+	return(write_read_multi(p_platform, reg_address, pdata, count, 1));
 }
 
 int32_t read_multi(
-		int fd,
-		uint16_t i2c_address,
+		VL53L8CX_Platform * p_platform,
 		uint16_t reg_address,
 		uint8_t *pdata,
 		uint32_t count)
 {
-	return(write_read_multi(fd, i2c_address, reg_address, pdata, count, 0));
+	return(write_read_multi(p_platform, reg_address, pdata, count, 0));
 }
 
 uint8_t VL53L8CX_RdByte(
@@ -310,7 +255,12 @@ uint8_t VL53L8CX_RdByte(
 		uint16_t reg_address,
 		uint8_t *p_value)
 {
-	return(read_multi(p_platform->fd, p_platform->address, reg_address, p_value, 1));
+	uint64_t start_us = VL53L8CX_StatsStart();
+	uint8_t status;
+
+	status = read_multi(p_platform, reg_address, p_value, 1);
+	VL53L8CX_StatsAdd(p_platform, VL53L8CX_STATS_RD_BYTE, start_us, 1, status);
+	return(status);
 }
 
 uint8_t VL53L8CX_WrByte(
@@ -318,7 +268,22 @@ uint8_t VL53L8CX_WrByte(
 		uint16_t reg_address,
 		uint8_t value)
 {
-	return(write_multi(p_platform->fd, p_platform->address, reg_address, &value, 1));
+	uint64_t start_us;
+	int32_t status;
+
+	if ((reg_address == VL53L8CX_PAGE_REGISTER) && p_platform->page_valid
+		&& (p_platform->page == value))
+		return 0;
+
+	start_us = VL53L8CX_StatsStart();
+	status = write_multi(p_platform, reg_address, &value, 1);
+	if (reg_address == VL53L8CX_PAGE_REGISTER) {
+		p_platform->page = value;
+		p_platform->page_valid = (status == 0);
+	}
+	VL53L8CX_StatsAdd(p_platform, VL53L8CX_STATS_WR_BYTE, start_us, 1, (uint8_t)status);
+
+	return(status);
 }
 
 uint8_t VL53L8CX_RdMulti(
@@ -327,7 +292,12 @@ uint8_t VL53L8CX_RdMulti(
 		uint8_t *p_values,
 		uint32_t size)
 {
-	return(read_multi(p_platform->fd, p_platform->address, reg_address, p_values, size));
+	uint64_t start_us = VL53L8CX_StatsStart();
+	uint8_t status;
+
+	status = read_multi(p_platform, reg_address, p_values, size);
+	VL53L8CX_StatsAdd(p_platform, VL53L8CX_STATS_RD_MULTI, start_us, size, status);
+	return(status);
 }
 
 uint8_t VL53L8CX_WrMulti(
@@ -336,125 +306,411 @@ uint8_t VL53L8CX_WrMulti(
 		uint8_t *p_values,
 		uint32_t size)
 {
-	return(write_multi(p_platform->fd, p_platform->address, reg_address, p_values, size));
-}
-
-void VL53L8CX_SwapBuffer(
-		uint8_t 		*buffer,
-		uint16_t 	 	 size)
-{
-	uint32_t i, tmp;
-	
-	/* Example of possible implementation using <string.h> */
-	for(i = 0; i < size; i = i + 4) 
-	{
-		tmp = (
-		  buffer[i]<<24)
-		|(buffer[i+1]<<16)
-		|(buffer[i+2]<<8)
-		|(buffer[i+3]);
-		
-		memcpy(&(buffer[i]), &tmp, 4);
-	}
-}	
+	uint64_t start_us = VL53L8CX_StatsStart();
+	uint8_t status;
+
+	status = write_multi(p_platform, reg_address, p_values, size);
+	VL53L8CX_StatsAdd(p_platform, VL53L8CX_STATS_WR_MULTI, start_us, size, status);
+	return(status);
+}
+
+void VL53L8CX_InvalidatePage(
+		VL53L8CX_Platform * p_platform)
+{
+	p_platform->page_valid = 0;
+}
+
+uint8_t VL53L8CX_BeginTransaction(
+		VL53L8CX_Platform * p_platform)
+{
+	/* Beginning a transaction while one is open sends the pending
+	 * accesses first */
+	if (p_platform->tr_active)
+		return (uint8_t)(comms_flush_transaction(p_platform) != 0);
+
+	p_platform->tr_active = 1;
+	p_platform->tr_status = 0;
+
+	return 0;
+}
+
+uint8_t VL53L8CX_CommitTransaction(
+		VL53L8CX_Platform * p_platform)
+{
+	uint64_t start_us = VL53L8CX_StatsStart();
+	uint32_t size = 0;
+	uint16_t i;
+	uint8_t status;
+
+	for (i = 0; i < p_platform->tr_nb_accesses; i++)
+		size += p_platform->tr_accesses[i].count;
+
+	(void)comms_flush_transaction(p_platform);
+	status = p_platform->tr_status;
+	VL53L8CX_StatsAdd(p_platform, VL53L8CX_STATS_COMMIT, start_us, size, status);
+	p_platform->tr_active = 0;
+	p_platform->tr_status = 0;
+
+	return status;
+}
 
 uint8_t VL53L8CX_WaitMs(
 		VL53L8CX_Platform * p_platform,
 		uint32_t time_ms)
 {
-	usleep(time_ms*1000);
+	uint64_t start_us = VL53L8CX_StatsStart();
+
+	if ((p_platform != NULL) && (p_platform->transport != NULL)
+		&& (p_platform->transport->sleep_until != NULL))
+		p_platform->transport->sleep_until(p_platform,
+			VL53L8CX_GetTimeUs(p_platform) + ((uint64_t)time_ms * 1000));
+	else
+		usleep(time_ms*1000);
+
+	if (p_platform != NULL)
+		VL53L8CX_StatsAdd(p_platform, VL53L8CX_STATS_SLEEP, start_us, 0, 0);
 	return 0;
 }
 
+uint8_t VL53L8CX_WaitUs(
+		VL53L8CX_Platform * p_platform,
+		uint32_t time_us)
+{
+	uint64_t start_us = VL53L8CX_StatsStart();
+	struct timespec ts;
+
+	if ((p_platform != NULL) && (p_platform->transport != NULL)
+		&& (p_platform->transport->sleep_until != NULL)) {
+		p_platform->transport->sleep_until(p_platform,
+			VL53L8CX_GetTimeUs(p_platform) + time_us);
+	}
+	else {
+		ts.tv_sec = time_us / 1000000;
+		ts.tv_nsec = (time_us % 1000000) * 1000;
+		while ((nanosleep(&ts, &ts) != 0) && (errno == EINTR))
+			;
+	}
+
+	if (p_platform != NULL)
+		VL53L8CX_StatsAdd(p_platform, VL53L8CX_STATS_SLEEP, start_us, 0, 0);
+	return 0;
+}
+
+uint64_t VL53L8CX_GetTimeUs(
+		VL53L8CX_Platform * p_platform)
+{
+	if ((p_platform != NULL) && (p_platform->transport != NULL)
+		&& (p_platform->transport->get_time_us != NULL))
+		return p_platform->transport->get_time_us(p_platform);
+
+	return VL53L8CX_ClockTimeUs();
+}
+
+#ifndef VL53L8CX_DISABLE_STATS
+uint64_t VL53L8CX_StatsStart(void)
+{
+	return VL53L8CX_ClockTimeUs();
+}
+
+void VL53L8CX_StatsAdd(
+		VL53L8CX_Platform * p_platform,
+		uint8_t operation,
+		uint64_t start_us,
+		uint32_t size,
+		uint8_t status)
+{
+	VL53L8CX_OperationStats *p_op;
+	uint64_t elapsed_us = VL53L8CX_ClockTimeUs() - start_us;
+	uint32_t latency_us, bucket = 0;
+
+	if (operation >= VL53L8CX_STATS_NB_OPERATIONS)
+		return;
+
+	latency_us = (elapsed_us > UINT32_MAX) ? UINT32_MAX : (uint32_t)elapsed_us;
+	if (latency_us != 0) {
+		bucket = 32 - (uint32_t)__builtin_clz(latency_us);
+		if (bucket >= VL53L8CX_STATS_NB_BUCKETS)
+			bucket = VL53L8CX_STATS_NB_BUCKETS - 1;
+	}
 
+	p_op = &p_platform->stats.op[operation];
+	p_op->count++;
+	if (status != 0)
+		p_op->errors++;
+	p_op->size += size;
+	p_op->total_us += latency_us;
+	if (latency_us > p_op->max_us)
+		p_op->max_us = latency_us;
+	p_op->histogram[bucket]++;
+}
+
+void VL53L8CX_GetStats(
+		VL53L8CX_Platform * p_platform,
+		VL53L8CX_Stats *p_stats)
+{
+	memcpy(p_stats, &p_platform->stats, sizeof(*p_stats));
+}
+
+void VL53L8CX_ResetStats(
+		VL53L8CX_Platform * p_platform)
+{
+	memset(&p_platform->stats, 0, sizeof(p_platform->stats));
+}
+#else
+void VL53L8CX_GetStats(
+		VL53L8CX_Platform * p_platform,
+		VL53L8CX_Stats *p_stats)
+{
+	memset(p_stats, 0, sizeof(*p_stats));
+}
+
+void VL53L8CX_ResetStats(
+		VL53L8CX_Platform * p_platform)
+{
+}
+#endif
+
+
+
+#define VL53L8CX_FRAME_MIN_GUARD_US	200
+#define VL53L8CX_FRAME_FINE_POLL_US	250
+#define VL53L8CX_FRAME_COARSE_POLL_US	5000
+#define VL53L8CX_FRAME_MAX_SKIP		8
+#define VL53L8CX_FRAME_MAX_OUTLIERS	4
 
-#ifdef SPI
 /*
- * A write/read SPI transfer with NCS low throughout
+ * Sleep until an absolute time given by VL53L8CX_GetTimeUs()
  */
-static int32_t SPI_Xfer(int device_handle, uint8_t* write_data, uint8_t* read_data, uint32_t len, uint32_t speed_hz)
+static void Sleep_Until(VL53L8CX_Platform *p_platform, uint64_t time_us)
 {
-	int32_t error = -1;
-	struct spi_ioc_transfer message;
+	uint64_t start_us = VL53L8CX_StatsStart();
+	struct timespec ts;
 
-	if(device_handle != 0)
-	{
-		memset(&message, 0, sizeof(message));
+	if (p_platform->transport->sleep_until != NULL) {
+		p_platform->transport->sleep_until(p_platform, time_us);
+	}
+	else {
+		ts.tv_sec = time_us / 1000000;
+		ts.tv_nsec = (time_us % 1000000) * 1000;
+		while (clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &ts, NULL) == EINTR)
+			;
+	}
 
-		message.tx_buf = (unsigned long)write_data;
-		message.rx_buf = (unsigned long)read_data;
-		message.len = len;
-		message.delay_usecs = 0;
-		message.speed_hz = VL53L8CX_SPI_SPEED_HZ;
-		message.bits_per_word = VL53L8CX_SPI_NB_BITS;
+	VL53L8CX_StatsAdd(p_platform, VL53L8CX_STATS_SLEEP, start_us, 0, 0);
+}
 
-		error = ioctl(device_handle, SPI_IOC_MESSAGE(1), &message);
+/*
+ * Margin taken before the expected frame, from the observed jitter
+ */
+static uint32_t Frame_Guard(VL53L8CX_Configuration *p_dev)
+{
+	uint32_t guard = 2 * p_dev->frame_jitter_us + VL53L8CX_FRAME_MIN_GUARD_US;
+
+	if (guard > p_dev->frame_period_us / 4)
+		guard = p_dev->frame_period_us / 4;
+	return guard;
+}
+
+/*
+ * Record a frame seen at ready_us, 'frames' stream counts after the previous
+ * one. When the time is measured, the period follows the sensor clock drift
+ * through an exponential average. A sample far from the model is ignored
+ * unless it repeats, as after a change of ranging frequency.
+ */
+static void Frame_Update(VL53L8CX_Configuration *p_dev, uint64_t ready_us,
+		uint8_t frames, uint8_t measured)
+{
+	uint32_t sample, error;
+	uint32_t period = p_dev->frame_period_us;
 
-		if (error < 0) {
-			LOG("Linux_SPI_Xfer: linux spi error (%d): Write ptr (0x%08x), Read ptr (0x%08x). xfre len (%d), speed_hz(%d)", error, (int)(uintptr_t)write_data, (int)(uintptr_t)read_data, len, message.speed_hz);
-			return error;
-		} else {
-			return 0;
+	if (measured && (p_dev->frame_ready_us != 0) && (ready_us > p_dev->frame_ready_us)
+		&& (frames >= 1) && (frames <= VL53L8CX_FRAME_MAX_SKIP)) {
+		sample = (uint32_t)((ready_us - p_dev->frame_ready_us) / frames);
+		error = (sample > period) ? (sample - period) : (period - sample);
+
+		if (period == 0) {
+			p_dev->frame_period_us = sample;
+		}
+		else if (error <= period / 4) {
+			p_dev->frame_period_us += ((int32_t)sample - (int32_t)period) / 8;
+			p_dev->frame_jitter_us += ((int32_t)error - (int32_t)p_dev->frame_jitter_us) / 8;
+			p_dev->frame_outliers = 0;
+		}
+		else if (++p_dev->frame_outliers >= VL53L8CX_FRAME_MAX_OUTLIERS) {
+			p_dev->frame_period_us = sample;
+			p_dev->frame_jitter_us = 0;
+			p_dev->frame_outliers = 0;
 		}
-	} else {
-		LOG("Linux_SPI_Xfer: attempt to use an invalid handle");
-		return -1;
 	}
-}	
-
+	p_dev->frame_ready_us = ready_us;
+}
 
-static int32_t Linux_SPI_Read_16M(int fd, uint16_t index, uint8_t* read_data, uint32_t read_size, uint32_t speed_hz)
+/*
+ * Poll data ready without interrupt line: sleep until shortly before the next
+ * expected frame, then poll in a short window. Without a frame period yet, or
+ * once the frame is clearly late, poll every VL53L8CX_FRAME_COARSE_POLL_US.
+ * Returns 0 when data is ready.
+ */
+static uint8_t Poll_Predictive(VL53L8CX_Configuration *p_dev, uint64_t deadline_us)
 {
-	int32_t status = 0;
-	uint8_t* read_buffer = malloc(read_size + 2);
-	uint8_t* write_buffer = malloc(read_size + 2);
-
-	/* clear top bit of index - bit 15 is 0 for a read operation on this protocol */
-	index = index & 0x7FFF;
-	write_buffer[0] = (uint8_t)((index & 0xFF00)>>8);
-	write_buffer[1] = (uint8_t)(index & 0xFF);
+	VL53L8CX_Platform *p_platform = &p_dev->platform;
+	uint32_t period = p_dev->frame_period_us;
+	uint32_t guard = 0, interval;
+	uint64_t now, expected = 0, wake = 0, last_check = 0, anchor;
+	uint8_t stream = p_dev->streamcount;
+	uint8_t isReady = 0, checks = 0;
+
+	now = VL53L8CX_GetTimeUs(p_platform);
+	if ((period != 0) && (p_dev->frame_ready_us != 0)) {
+		guard = Frame_Guard(p_dev);
+		expected = p_dev->frame_ready_us + period;
+		if (now + guard < expected) {
+			wake = expected - guard;
+			if ((deadline_us != 0) && (wake > deadline_us))
+				wake = deadline_us;
+			Sleep_Until(p_platform, wake);
+		}
+	}
 
-	status = SPI_Xfer(fd, write_buffer, read_buffer, read_size + 2, speed_hz);
+	for (;;) {
+		if (vl53l8cx_check_data_ready(p_dev, &isReady) != 0)
+			return VL53L8CX_STATUS_ERROR;
+		now = VL53L8CX_GetTimeUs(p_platform);
+		if (isReady)
+			break;
+		if ((deadline_us != 0) && (now >= deadline_us))
+			return VL53L8CX_STATUS_TIMEOUT_ERROR;
+
+		last_check = now;
+		if (checks < 255)
+			checks++;
+
+		if ((expected != 0) && (now < expected + period / 4))
+			interval = VL53L8CX_FRAME_FINE_POLL_US;
+		else
+			interval = VL53L8CX_FRAME_COARSE_POLL_US;
+
+		if ((deadline_us != 0) && (now + interval > deadline_us))
+			Sleep_Until(p_platform, deadline_us);
+		else
+			Sleep_Until(p_platform, now + interval);
+	}
 
-	if (status == 0)
-		memcpy(read_data, read_buffer + 2, read_size);
+	if (checks != 0) {
+		/* New frame between the last two reads */
+		Frame_Update(p_dev, last_check + (now - last_check) / 2,
+			(uint8_t)(p_dev->streamcount - stream), 1);
+	}
+	else if (expected != 0) {
+		/* Frame already there at the first read: keep the phase on the
+		 * early side, so that the next frame is caught in the polling
+		 * window, and widen the window */
+		if (wake != 0)
+			anchor = wake;
+		else if (now >= expected)
+			anchor = expected + ((now - expected) / period) * period;
+		else
+			anchor = now;
+		p_dev->frame_jitter_us += guard / 4;
+		Frame_Update(p_dev, anchor, 0, 0);
+	}
+	else
+		Frame_Update(p_dev, now, 0, 0);
 
-	free(read_buffer);
-	free(write_buffer);
+	return VL53L8CX_STATUS_OK;
+}
 
-	return status;
+/*
+ * Device of a platform structure, which is its 'platform' member
+ */
+static VL53L8CX_Configuration *Platform_Device(VL53L8CX_Platform *p_platform)
+{
+	return (VL53L8CX_Configuration *)(void *)((uint8_t *)p_platform
+		- offsetof(VL53L8CX_Configuration, platform));
 }
 
-static int32_t Linux_SPI_Write_16M(int fd, uint16_t index, uint8_t* write_data, uint32_t write_size, uint32_t speed_hz)
+static uint8_t Wait_DataReady(
+		VL53L8CX_Platform *p_platform,
+		uint64_t deadline_us)
 {
-	int32_t status = 0;
-	uint8_t* read_buffer = malloc(write_size + 2);
-	uint8_t* write_buffer = malloc(write_size + 2);
+	VL53L8CX_Configuration * p_dev = Platform_Device(p_platform);
+	int32_t ret;
+	uint64_t now;
+	int timeout_ms = -1;
+	uint8_t isReady = 0;
 
-	write_buffer[0] = (uint8_t)(((index & 0xFF00)>>8 | 0x80));
-	write_buffer[1] = (uint8_t)(index & 0xFF);
-	memcpy(write_buffer + 2, write_data, write_size);
+	if (p_platform->transport->wait_interrupt != NULL) {
+		ret = p_platform->transport->wait_interrupt(p_platform, deadline_us);
+		if (ret == 1)
+			return VL53L8CX_STATUS_OK;
+		if (ret == 0)
+			return VL53L8CX_STATUS_TIMEOUT_ERROR;
+		if (ret == -1)
+			return VL53L8CX_STATUS_ERROR;
+		/* Interrupt not available, poll */
+	}
 
-	status = SPI_Xfer(fd, write_buffer, read_buffer, write_size + 2, speed_hz);
+	while (p_platform->gpio_fd >= 0) {
+		if (deadline_us != 0) {
+			now = VL53L8CX_GetTimeUs(p_platform);
+			if (now >= deadline_us)
+				return VL53L8CX_STATUS_TIMEOUT_ERROR;
+			timeout_ms = (int)((deadline_us - now + 999) / 1000);
+		}
 
-	free(read_buffer);
-	free(write_buffer);
+		/* The edge is confirmed by the stream count, so that a stale
+		 * event from a previous frame is not reported as new data */
+		ret = GPIO_WaitEdge(p_platform, timeout_ms);
+		if (ret < 0) {
+			LOG("INT line wait failed, polling data ready\n");
+			close(p_platform->gpio_fd);
+			p_platform->gpio_fd = -1;
+			break;
+		}
+		if (ret == 0)
+			return VL53L8CX_STATUS_TIMEOUT_ERROR;
 
-	return status;
+		if (vl53l8cx_check_data_ready(p_dev, &isReady) != 0)
+			return VL53L8CX_STATUS_ERROR;
+		if (isReady)
+			return VL53L8CX_STATUS_OK;
+	}
+
+	return Poll_Predictive(p_dev, deadline_us);
 }
-#endif
-uint8_t VL53L8CX_wait_for_dataready(VL53L8CX_Platform *p_platform)
+
+uint8_t VL53L8CX_wait_for_dataready_until(
+		VL53L8CX_Platform *p_platform,
+		uint64_t deadline_us)
 {
-#ifdef STMVL53L8CX_KERNEL
-	if (ioctl(p_platform->fd, ST_TOF_IOCTL_WAIT_FOR_INTERRUPT) < 0)
-		return 0;
+#ifndef VL53L8CX_DISABLE_STATS
+	uint64_t start_us = VL53L8CX_StatsStart();
+	uint32_t checks = p_platform->stats.op[VL53L8CX_STATS_DATA_READY].count;
+	uint8_t status;
+
+	/* The sensor reads of the wait are its data ready checks */
+	status = Wait_DataReady(p_platform, deadline_us);
+	VL53L8CX_StatsAdd(p_platform, VL53L8CX_STATS_POLL, start_us,
+		p_platform->stats.op[VL53L8CX_STATS_DATA_READY].count - checks, status);
+
+	return status;
 #else
-	VL53L8CX_Configuration * p_dev = (VL53L8CX_Configuration *)(p_platform - offsetof(VL53L8CX_Configuration, platform));
-	uint8_t isReady = 0;
-	do {
-		VL53L8CX_WaitMs(p_platform, 5);
-		vl53l8cx_check_data_ready(p_dev, &isReady);		
-	} while (isReady == 0);
+	return Wait_DataReady(p_platform, deadline_us);
 #endif
-	return 1;
-}
\ No newline at end of file
+}
+
+uint8_t VL53L8CX_wait_for_dataready(VL53L8CX_Platform *p_platform)
+{
+	VL53L8CX_Configuration * p_dev = Platform_Device(p_platform);
+	uint64_t deadline_us = 0;
+
+	if (p_platform->int_timeout_ms != 0)
+		deadline_us = VL53L8CX_GetTimeUs(p_platform)
+			+ (uint64_t)p_platform->int_timeout_ms * 1000;
+	if ((p_dev->deadline_us != 0)
+		&& ((deadline_us == 0) || (p_dev->deadline_us < deadline_us)))
+		deadline_us = p_dev->deadline_us;
+
+	return (VL53L8CX_wait_for_dataready_until(p_platform, deadline_us)
+		== VL53L8CX_STATUS_OK) ? 1 : 0;
+}
@@ -25,56 +25,438 @@
  * layer.
  */
 
+/*
+ * @brief Size of the queue used by VL53L8CX_BeginTransaction(): maximum number
+ * of register accesses, and bytes of write data copied into the queue.
+ */
+
+#define VL53L8CX_TR_MAX_ACCESSES	32U
+#define VL53L8CX_TR_DATA_SIZE		256U
+
+/*
+ * @brief Size of the GPIO character device path used for the INT line.
+ */
+
+#define VL53L8CX_GPIO_CHIP_NAME_SIZE	32U
+
+/*
+ * @brief Size of the device node path of a transport.
+ */
+
+#define VL53L8CX_DEVICE_NAME_SIZE	32U
+
+/*
+ * @brief Size of the path of a bus trace file.
+ */
+
+#define VL53L8CX_TRACE_FILE_SIZE	128U
+
+/**
+ * @brief Register access queued by a transaction.
+ */
 
-#ifdef SPI
 typedef struct
 {
-	/* To be filled with customer's platform.
-	 * needs to be added */
-	/* address is not used but here only to build for compatibility with I2C setting function in driver */
-	uint16_t address;
-	uint8_t spi_num;
-	uint8_t spi_cs;
+	uint16_t reg_address;
+	uint8_t write_not_read;
+	uint32_t count;
+	uint8_t *p_data;
+} VL53L8CX_Access;
 
-	/* For Linux implementation, file descriptor */
-	int fd;
 
-} VL53L8CX_Platform;
+/*
+ * @brief The macro below can be used to compile the bus traffic and latency
+ * statistics out (see VL53L8CX_GetStats()), e.g. to save the clock reads of
+ * each bus access and their storage in VL53L8CX_Platform. VL53L8CX_GetStats()
+ * then gives 0.
+ */
+
+// #define 	VL53L8CX_DISABLE_STATS
+
+/*
+ * @brief Operations counted by the bus statistics of a device. Inside a
+ * transaction, the register accesses are only queued: their bus time is
+ * counted by VL53L8CX_STATS_COMMIT.
+ */
+
+#define VL53L8CX_STATS_WR_BYTE		0U
+#define VL53L8CX_STATS_RD_BYTE		1U
+#define VL53L8CX_STATS_RD_MULTI		2U
+#define VL53L8CX_STATS_WR_MULTI		3U
+#define VL53L8CX_STATS_COMMIT		4U
+#define VL53L8CX_STATS_DCI_READ		5U
+#define VL53L8CX_STATS_DCI_WRITE	6U
+#define VL53L8CX_STATS_POLL		7U
+#define VL53L8CX_STATS_DATA_READY	8U
+#define VL53L8CX_STATS_SLEEP		9U
+#define VL53L8CX_STATS_RANGING_DATA	10U
+#define VL53L8CX_STATS_NB_OPERATIONS	11U
+
+/*
+ * @brief Latency histogram buckets: bucket 0 counts the operations under
+ * 1 us, bucket n those in [2^(n-1), 2^n[ us, and the last one all the longer
+ * ones (from 4.2 s).
+ */
+
+#define VL53L8CX_STATS_NB_BUCKETS	24U
+
+/**
+ * @brief Statistics of one operation kind. 'size' is the number of bytes
+ * transferred for the bus and DCI accesses, the number of sensor reads for
+ * the polls (answers of the firmware and data ready waits), and the number of
+ * new frames found for the data ready checks.
+ */
+
+typedef struct
+{
+	uint32_t count;
+	uint32_t errors;
+	uint64_t size;
+	uint64_t total_us;
+	uint32_t max_us;
+	uint32_t histogram[VL53L8CX_STATS_NB_BUCKETS];
+} VL53L8CX_OperationStats;
+
+/**
+ * @brief Bus traffic and latency statistics of a device, indexed by
+ * VL53L8CX_STATS_* operation.
+ */
+
+typedef struct
+{
+	VL53L8CX_OperationStats op[VL53L8CX_STATS_NB_OPERATIONS];
+} VL53L8CX_Stats;
+
+struct VL53L8CX_Transport;
 
-#else
 typedef struct
 {
 	/* To be filled with customer's platform. At least an I2C address/descriptor
 	 * needs to be added */
-	/* Example for most standard platform : I2C address of sensor */
+
+	/* Transport used to reach the sensor, to be set before
+	 * vl53l8cx_comms_init(). Left NULL, the build default is used: kernel
+	 * module with STMVL53L8CX_KERNEL, spidev with SPI, i2c-dev otherwise */
+	const struct VL53L8CX_Transport *transport;
+
+	/* Device node, e.g. "/dev/i2c-1" or "/dev/stmvl53l8cx1". Left empty,
+	 * the transport default is used */
+	char device[VL53L8CX_DEVICE_NAME_SIZE];
+
+	/* Example for most standard platform : I2C address of sensor, 0x52 if
+	 * left to 0 */
 	uint16_t  			address;
 
+	/* spidev bus and chip select, used when device is empty */
+	uint8_t spi_num;
+	uint8_t spi_cs;
+
 	/* For Linux implementation, file descriptor */
 	int fd;
 
+	/* Private state of a transport which is not a device node (emulator),
+	 * allocated by its open() and released by its close() */
+	void *transport_data;
+
+	/* I2C_RDWR limits, lowered at runtime if the adapter rejects a
+	 * transfer */
+	uint16_t i2c_max_len;
+	uint8_t i2c_max_msgs;
+
+	/* I2C_RDWR messages and staging buffer for the register index and
+	 * write data, allocated by vl53l8cx_comms_init() and released by
+	 * vl53l8cx_comms_close() */
+	void *i2c_msgs;
+	uint8_t *i2c_buffer;
+
+	/* spidev 'bufsiz' limit, read by vl53l8cx_comms_init() */
+	uint32_t spi_bufsiz;
+
+	/* Pending SPI_IOC_MESSAGE: transfer descriptors and register index
+	 * headers, allocated by vl53l8cx_comms_init() and released by
+	 * vl53l8cx_comms_close() */
+	void *spi_xfers;
+	uint8_t *spi_headers;
+	uint16_t spi_nb_xfers;
+	uint32_t spi_tx_total;
+	uint32_t spi_rx_total;
+
+	/* Set when the kernel module does not implement
+	 * ST_TOF_IOCTL_TRANSFER_BATCH */
+	uint8_t no_batch_ioctl;
+
+	/* Set when the kernel module does not implement
+	 * ST_TOF_IOCTL_WAIT_FOR_INTERRUPT_DEADLINE */
+	uint8_t no_wait_deadline_ioctl;
+
+	/* Last value written to the page register (0x7fff), valid when
+	 * page_valid is set */
+	uint8_t page;
+	uint8_t page_valid;
+
+	/* Register accesses queued between VL53L8CX_BeginTransaction() and
+	 * VL53L8CX_CommitTransaction() */
+	uint8_t tr_active;
+	uint8_t tr_status;
+	uint16_t tr_nb_accesses;
+	uint16_t tr_data_size;
+	VL53L8CX_Access tr_accesses[VL53L8CX_TR_MAX_ACCESSES];
+	uint8_t tr_data[VL53L8CX_TR_DATA_SIZE];
+
+	/* Optional INT line used by VL53L8CX_wait_for_dataready() when the
+	 * transport has no interrupt: GPIO character device (e.g.
+	 * "/dev/gpiochip0") and line offset, to be set before
+	 * vl53l8cx_comms_init(). Data ready is polled when gpio_chip is empty
+	 * or the line cannot be requested. vl53l8cx_comms_init() fails if
+	 * gpio_chip is set for a transport with an interrupt, e.g. the bus
+	 * trace ones */
+	char gpio_chip[VL53L8CX_GPIO_CHIP_NAME_SIZE];
+	uint32_t gpio_line;
+	int gpio_fd;
+
+	/* Maximum time waited by VL53L8CX_wait_for_dataready(), 0 waits
+	 * forever */
+	uint32_t int_timeout_ms;
+
+	/* Bus trace, to be set before vl53l8cx_comms_init(): file written by
+	 * VL53L8CX_RecorderTransport or read by VL53L8CX_ReplayTransport,
+	 * transport recorded (NULL for the build default), and replay at the
+	 * recorded pace instead of full speed */
+	char trace_file[VL53L8CX_TRACE_FILE_SIZE];
+	const struct VL53L8CX_Transport *trace_transport;
+	uint8_t trace_realtime;
+	void *trace_data;
+
+#ifndef VL53L8CX_DISABLE_STATS
+	/* Bus traffic and latency statistics, cleared by
+	 * vl53l8cx_comms_init() and VL53L8CX_ResetStats() */
+	VL53L8CX_Stats stats;
+#endif
+
 } VL53L8CX_Platform;
 
+/**
+ * @brief Operations of a transport backend. A transport moves the register
+ * accesses between the host and one sensor, the platform layer above it
+ * handles the transactions, the page cache and the data ready waits.
+ */
+
+typedef struct VL53L8CX_Transport
+{
+	/* Name, for logs */
+	const char *name;
+
+	/* Open the device and allocate the transport resources. Returns 0 if OK,
+	 * and releases everything on error */
+	int32_t (*open)(VL53L8CX_Platform *p_platform);
+
+	/* Release what open() allocated */
+	void (*close)(VL53L8CX_Platform *p_platform);
+
+	/* Send a list of register accesses, in order, in as few bus
+	 * submissions as possible. Returns 0 if OK */
+	int32_t (*submit)(
+			VL53L8CX_Platform *p_platform,
+			VL53L8CX_Access *accesses,
+			uint16_t nb_accesses);
+
+	/* Optional, NULL if the transport has no interrupt: wait for the sensor
+	 * interrupt until deadline_us (0 waits forever). Returns 1 on
+	 * interrupt, 0 on timeout, -1 on error, -2 if the interrupt is not
+	 * available and data ready must be polled */
+	int32_t (*wait_interrupt)(
+			VL53L8CX_Platform *p_platform,
+			uint64_t deadline_us);
+
+	/* Optional, NULL for the system clock: monotonic time in us, and sleep
+	 * until a time given by get_time_us(). A replay runs on the recorded
+	 * time */
+	uint64_t (*get_time_us)(VL53L8CX_Platform *p_platform);
+	void (*sleep_until)(
+			VL53L8CX_Platform *p_platform,
+			uint64_t time_us);
+
+} VL53L8CX_Transport;
+
+/**
+ * @brief Transports provided for Linux: i2c-dev, spidev, and the stmvl53l8cx
+ * kernel module.
+ */
+
+extern const VL53L8CX_Transport VL53L8CX_I2cTransport;
+extern const VL53L8CX_Transport VL53L8CX_SpiTransport;
+extern const VL53L8CX_Transport VL53L8CX_KernelTransport;
+
+/*
+ * @brief Transport used when none is set in the platform structure.
+ */
+
+#ifdef STMVL53L8CX_KERNEL
+#define VL53L8CX_DEFAULT_TRANSPORT	(&VL53L8CX_KernelTransport)
+#elif defined(SPI)
+#define VL53L8CX_DEFAULT_TRANSPORT	(&VL53L8CX_SpiTransport)
+#else
+#define VL53L8CX_DEFAULT_TRANSPORT	(&VL53L8CX_I2cTransport)
 #endif
 
+/**
+ * @brief Bus trace transports. VL53L8CX_RecorderTransport runs the sessions
+ * through trace_transport and writes every register access (direction,
+ * register index, payload), interrupt wait and time query, with its
+ * monotonic time, into trace_file. VL53L8CX_ReplayTransport plays trace_file
+ * back to the ULD, at full speed on the recorded time, or at the recorded
+ * pace if trace_realtime is set. The replay stops with an error as soon as
+ * the ULD does not issue the recorded access. The INT line through the GPIO
+ * character device is not used while recording or replaying: gpio_chip must
+ * stay empty.
+ */
+
+extern const VL53L8CX_Transport VL53L8CX_RecorderTransport;
+extern const VL53L8CX_Transport VL53L8CX_ReplayTransport;
+
+/**
+ * @brief Print a bus trace as text on the standard output, one record per
+ * line, e.g. to compare the bus traffic of two driver versions with diff.
+ * Payloads longer than 16 bytes are shortened, with a hash of the full
+ * payload.
+ * @param (const char*) trace_file : Trace written by
+ * VL53L8CX_RecorderTransport.
+ * @param (uint8_t) with_time : 1 to print the time of the records and the
+ * time queries, 0 to print the bus accesses and interrupt waits only.
+ * @return (int32_t) status : 0 if OK
+ */
+
+int32_t VL53L8CX_TraceDump(
+		const char *trace_file,
+		uint8_t with_time);
+
+/**
+ * @brief Transport emulating a sensor in the process, for tests and
+ * benchmarks without hardware. It answers the boot, firmware download, NVM,
+ * DCI and power mode sequences of the ULD, and streams synthetic frames built
+ * from the output list programmed by vl53l8cx_start_ranging(), at the
+ * programmed ranging frequency.
+ */
+
+extern const VL53L8CX_Transport VL53L8CX_EmulatorTransport;
+
+/*
+ * @brief Number of zones of an emulated scene (8x8). In 4x4, a zone shows the
+ * top left zone of its 2x2 group.
+ */
+
+#define VL53L8CX_EMULATOR_NB_ZONES	64U
+
+/**
+ * @brief Scene rendered by the emulator transport. Frame faults are drawn from
+ * a pseudo random generator, so that a seed always gives the same stream.
+ */
+
+typedef struct
+{
+	/* Distance of the target of each zone, 0 for no target */
+	uint16_t distance_mm[VL53L8CX_EMULATOR_NB_ZONES];
+
+	/* Reflectance of the target of each zone */
+	uint8_t reflectance_percent[VL53L8CX_EMULATOR_NB_ZONES];
+
+	/* Ambient rate and silicon temperature reported in every frame */
+	uint32_t ambient_kcps_per_spad;
+	int8_t silicon_temp_degc;
+
+	/* Amplitude of the uniform noise added to each distance */
+	uint16_t noise_mm;
+
+	/* Probability in percent for a frame to be dropped by the sensor (no
+	 * data ready, the stream count skips it), and to be sent with a
+	 * footer id which does not match its header id */
+	uint8_t drop_percent;
+	uint8_t corrupt_percent;
+
+	/* Seed of the pseudo random generator, 0 keeps the current one */
+	uint32_t seed;
+
+} VL53L8CX_EmulatorScene;
+
+/**
+ * @brief Optional callback called by the emulator before building each frame,
+ * to animate the scene. 'frame' is the frame number since the start of the
+ * ranging session.
+ */
+
+typedef void (*VL53L8CX_EmulatorScript)(
+		VL53L8CX_EmulatorScene *p_scene,
+		uint32_t frame,
+		void *p_user);
+
+/**
+ * @brief Set the scene rendered by the emulator. The default scene is a flat
+ * wall at 1000 mm with a 50% reflectance, without noise or fault.
+ * @param (VL53L8CX_Platform*) p_platform : Pointer of VL53L8CX platform
+ * structure, opened with VL53L8CX_EmulatorTransport.
+ * @param (VL53L8CX_EmulatorScene*) p_scene : Scene to render.
+ * @return (uint8_t) status : 0 if OK
+ */
+
+uint8_t VL53L8CX_EmulatorSetScene(
+		VL53L8CX_Platform *p_platform,
+		const VL53L8CX_EmulatorScene *p_scene);
+
+/**
+ * @brief Set the callback animating the scene of the emulator.
+ * @param (VL53L8CX_Platform*) p_platform : Pointer of VL53L8CX platform
+ * structure, opened with VL53L8CX_EmulatorTransport.
+ * @param (VL53L8CX_EmulatorScript) script : Callback, NULL for a still scene.
+ * @param (void*) p_user : Pointer given back to the callback.
+ * @return (uint8_t) status : 0 if OK
+ */
+
+uint8_t VL53L8CX_EmulatorSetScript(
+		VL53L8CX_Platform *p_platform,
+		VL53L8CX_EmulatorScript script,
+		void *p_user);
+
 
 /*
  * @brief The macro below is used to define the number of target per zone sent
  * through I2C/SPI. This value can be changed by user, in order to tune I2C/SPI
  * transaction, and also the total memory size (a lower number of target per
- * zone means a lower RAM). The value must be between 1 and 4.
+ * zone means a lower RAM). The value must be between 1 and 4. This is the
+ * maximum and default value, vl53l8cx_set_nb_target_per_zone() can lower it for
+ * a device. It can also be given on the compiler command line.
  */
 
+#ifndef VL53L8CX_NB_TARGET_PER_ZONE
 #define 	VL53L8CX_NB_TARGET_PER_ZONE		1U
+#endif
 
 /*
  * @brief The macro below can be used to avoid data conversion into the driver.
  * By default there is a conversion between firmware and user data. Using this macro
  * allows to use the firmware format instead of user format. The firmware format allows
- * an increased precision.
+ * an increased precision. This is the default format of the devices, selected
+ * per device by vl53l8cx_set_raw_format().
  */
 
 // #define 	VL53L8CX_USE_RAW_FORMAT
 
+/*
+ * @brief The macro below can be used to convert the results with scalar code
+ * only. By default, the driver converts the results with SSE2 or NEON
+ * instructions when the compiler targets them.
+ */
+
+// #define 	VL53L8CX_DISABLE_SIMD
+
+/*
+ * @brief The macro below can be used to compute the CRC of the results packet
+ * (see vl53l8cx_set_results_crc()) while converting the results, instead of
+ * a separate pass on the frame. The conversion is slightly slower when the
+ * CRC is disabled.
+ */
+
+// #define 	VL53L8CX_FUSED_RESULTS_CRC
+
 /*
  * @brief All macro below are used to configure the sensor output. User can
  * define some macros if he wants to disable selected output, in order to reduce
@@ -151,6 +533,44 @@ uint8_t VL53L8CX_WrMulti(
 		uint8_t *p_values,
 		uint32_t size);
 
+/**
+ * @brief Function used to group register accesses into a single bus
+ * submission. Until VL53L8CX_CommitTransaction(), the RdByte, WrByte, RdMulti
+ * and WrMulti functions only queue the access: written values are copied into
+ * the queue, read values are only available once the transaction is committed.
+ * A write too large for the queue is sent immediately, after the pending
+ * accesses.
+ * @param (VL53L8CX_Platform*) p_platform : Pointer of VL53L8CX platform
+ * structure.
+ * @return (uint8_t) status : 0 if OK
+ */
+
+uint8_t VL53L8CX_BeginTransaction(
+		VL53L8CX_Platform * p_platform);
+
+/**
+ * @brief Function used to send the register accesses queued since
+ * VL53L8CX_BeginTransaction(), in order, and to close the transaction.
+ * @param (VL53L8CX_Platform*) p_platform : Pointer of VL53L8CX platform
+ * structure.
+ * @return (uint8_t) status : 0 if OK, or an error if any queued access failed
+ */
+
+uint8_t VL53L8CX_CommitTransaction(
+		VL53L8CX_Platform * p_platform);
+
+/**
+ * @brief Function used to forget the page selected on the sensor. The platform
+ * skips a page register (0x7fff) write when the page is already selected, so
+ * the cache must be invalidated each time the sensor may have lost its page
+ * (reset, reboot, power cycle).
+ * @param (VL53L8CX_Platform*) p_platform : Pointer of VL53L8CX platform
+ * structure.
+ */
+
+void VL53L8CX_InvalidatePage(
+		VL53L8CX_Platform * p_platform);
+
 /**
  * @brief Optional function, only used to perform an hardware reset of the
  * sensor. This function is not used in the API, but it can be used by the host.
@@ -166,16 +586,39 @@ uint8_t VL53L8CX_Reset_Sensor(
 
 /**
  * @brief This function is used to wait for a new measurement. It can 
- * support both interrupt mode with kernel module and polling mode
+ * support both interrupt mode with kernel module and polling mode. When the
+ * transport has no interrupt, the INT line is waited through the GPIO
+ * character device if gpio_chip is set. Otherwise the sensor is polled: the function sleeps
+ * until shortly before the next frame expected from the learnt frame period,
+ * then polls in a short window. The wait gives up after int_timeout_ms if
+ * not 0, or at the deadline_us of the device.
  * @param (VL53L8CX_Platform*) p_platform : Pointer of VL53L8CX platform
  * structure.
- * @return (uint8_t) status : 1 if data is ready
+ * @return (uint8_t) status : 1 if data is ready, 0 on timeout or error
  */
 uint8_t VL53L8CX_wait_for_dataready(VL53L8CX_Platform * p_platform);
 
+/**
+ * @brief This function is used to wait for a new measurement until an absolute
+ * deadline, through the transport interrupt if any. With the kernel module,
+ * the interrupt is waited through ST_TOF_IOCTL_WAIT_FOR_INTERRUPT_DEADLINE, or
+ * the sensor is polled if the module does not support it.
+ * @param (VL53L8CX_Platform*) p_platform : Pointer of VL53L8CX platform
+ * structure.
+ * @param (uint64_t) deadline_us : time given by VL53L8CX_GetTimeUs() at which
+ * the wait gives up, 0 waits forever.
+ * @return (uint8_t) status : 0 if data is ready, VL53L8CX_STATUS_TIMEOUT_ERROR
+ * if the deadline is reached, VL53L8CX_STATUS_ERROR otherwise.
+ */
+uint8_t VL53L8CX_wait_for_dataready_until(
+		VL53L8CX_Platform * p_platform,
+		uint64_t deadline_us);
+
 /**
  * @brief Mandatory function, used to swap a buffer. The buffer size is always a
- * multiple of 4 (4, 8, 12, 16, ...).
+ * multiple of 4 (4, 8, 12, 16, ...). The swap uses the SIMD instructions of
+ * the CPU (AVX2 or SSSE3 on x86, NEON on ARM builds with NEON), checked on the
+ * first call, or a scalar loop.
  * @param (uint8_t*) buffer : Buffer to swap, generally uint32_t
  * @param (uint16_t) size : Buffer size to swap
  */
@@ -183,6 +626,18 @@ uint8_t VL53L8CX_wait_for_dataready(VL53L8CX_Platform * p_platform);
 void VL53L8CX_SwapBuffer(
 		uint8_t 		*buffer,
 		uint16_t 	 	 size);
+
+/**
+ * @brief Function used to force the implementation of VL53L8CX_SwapBuffer(),
+ * e.g. to compare them in a benchmark.
+ * @param (const char*) name : "avx2", "ssse3", "neon" or "scalar", NULL for
+ * the fastest one supported by the CPU.
+ * @return (const char*) name : Implementation selected, NULL if it is not
+ * built or not supported by the CPU (the selection is then unchanged).
+ */
+
+const char *VL53L8CX_SelectSwapBuffer(
+		const char *name);
 /**
  * @brief Mandatory function, used to wait during an amount of time. It must be
  * filled as it's used into the API.
@@ -197,7 +652,99 @@ uint8_t VL53L8CX_WaitMs(
 		uint32_t TimeMs);
 
 /**
- * @brief I2C/SPI communication channel initialization
+ * @brief Mandatory function, used to wait during a short amount of time. It is
+ * used to poll the firmware answers.
+ * @param (VL53L8CX_Platform*) p_platform : Pointer of VL53L8CX platform
+ * structure.
+ * @param (uint32_t) time_us : Time to wait in us.
+ * @return (uint8_t) status : 0 if wait is finished.
+ */
+
+uint8_t VL53L8CX_WaitUs(
+		VL53L8CX_Platform * p_platform,
+		uint32_t time_us);
+
+/**
+ * @brief Mandatory function, used to read a monotonic clock.
+ * @param (VL53L8CX_Platform*) p_platform : Pointer of VL53L8CX platform
+ * structure.
+ * @return (uint64_t) time : Current time in us.
+ */
+
+uint64_t VL53L8CX_GetTimeUs(
+		VL53L8CX_Platform * p_platform);
+
+/**
+ * @brief Function used to read the system monotonic clock (CLOCK_MONOTONIC),
+ * whatever the transport. VL53L8CX_GetTimeUs() reads it unless the transport
+ * has its own time, e.g. a replay.
+ * @return (uint64_t) time : Current time in us.
+ */
+
+uint64_t VL53L8CX_ClockTimeUs(void);
+
+/**
+ * @brief Function used by the platform and the API to count an operation in
+ * the statistics of the device.
+ * @param (VL53L8CX_Platform*) p_platform : Pointer of VL53L8CX platform
+ * structure.
+ * @param (uint8_t) operation : VL53L8CX_STATS_* operation.
+ * @param (uint64_t) start_us : Time given by VL53L8CX_StatsStart() when the
+ * operation started.
+ * @param (uint32_t) size : Bytes, reads or frames, see VL53L8CX_OperationStats.
+ * @param (uint8_t) status : Status of the operation, 0 if OK.
+ */
+
+void VL53L8CX_StatsAdd(
+		VL53L8CX_Platform * p_platform,
+		uint8_t operation,
+		uint64_t start_us,
+		uint32_t size,
+		uint8_t status);
+
+/**
+ * @brief Function used to time an operation counted by VL53L8CX_StatsAdd(),
+ * on the system monotonic clock (a bus trace replay runs on the recorded
+ * time, the statistics keep the time spent by the host).
+ * @return (uint64_t) time : Current time in us.
+ */
+
+uint64_t VL53L8CX_StatsStart(void);
+
+#ifdef VL53L8CX_DISABLE_STATS
+#define VL53L8CX_StatsStart()	((uint64_t)0)
+#define VL53L8CX_StatsAdd(p_platform, operation, start_us, size, status) \
+	((void)(p_platform), (void)(operation), (void)(start_us), \
+	(void)(size), (void)(status))
+#endif
+
+/**
+ * @brief Function used to read the bus traffic and latency statistics of a
+ * device, e.g. to know how the frame budget is split between bus transfers,
+ * sleeps and data conversion (VL53L8CX_STATS_RANGING_DATA minus its
+ * VL53L8CX_STATS_RD_MULTI).
+ * @param (VL53L8CX_Platform*) p_platform : Pointer of VL53L8CX platform
+ * structure.
+ * @param (VL53L8CX_Stats*) p_stats : Statistics since vl53l8cx_comms_init() or
+ * the last VL53L8CX_ResetStats().
+ */
+
+void VL53L8CX_GetStats(
+		VL53L8CX_Platform * p_platform,
+		VL53L8CX_Stats *p_stats);
+
+/**
+ * @brief Function used to clear the statistics of a device.
+ * @param (VL53L8CX_Platform*) p_platform : Pointer of VL53L8CX platform
+ * structure.
+ */
+
+void VL53L8CX_ResetStats(
+		VL53L8CX_Platform * p_platform);
+
+/**
+ * @brief I2C/SPI communication channel initialization, through the transport
+ * selected in the platform structure.
  * @param (int) *fd : pointer on a I2C/SPI channel descriptor.
  * @return (uint8_t) status : 0 if OK
  */
@@ -0,0 +1,649 @@
+/**
+  *
+  * Copyright (c) 2023 STMicroelectronics.
+  * All rights reserved.
+  *
+  * This software is licensed under terms that can be found in the LICENSE file
+  * in the root directory of this software component.
+  * If no LICENSE file comes with this software, it is provided AS-IS.
+  *
+  ******************************************************************************
+  */
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "platform.h"
+#include "vl53l8cx_api.h"
+
+#define VL53L8CX_COMMS_ERROR		-2
+
+#define LOG 				printf
+
+/*
+ * Register map of the emulated sensor. The page register selects the GO1/GO2
+ * registers (page 0), the FW access registers (page 1), the UI RAM holding the
+ * results and the command area (page 2), or the FW RAM (pages 9 to 11).
+ */
+#define EMU_PAGE_REGISTER		0x7fff
+#define EMU_PAGE_SIZE			0x8000U
+#define EMU_PAGE_GO			0x00
+#define EMU_PAGE_FW_ACCESS		0x01
+#define EMU_PAGE_UI			0x02
+#define EMU_PAGE_FW_FIRST		0x09
+#define EMU_PAGE_FW_LAST		0x0b
+
+#define EMU_DEVICE_ID			0xF0
+#define EMU_REVISION_ID			0x0C
+#define EMU_FW_SIZE			0x15000U
+#define EMU_FW_CHECKSUM			0xcadf7cafU
+#define EMU_FW_CHECKSUM_ADDRESS		0x2FFC
+
+/* Commands, given by the 4 last bytes of the command area: tag, operation,
+ * and size of the command before them */
+#define EMU_CMD_WRITE			0x01
+#define EMU_CMD_READ			0x02
+#define EMU_CMD_START			0x03
+#define EMU_CMD_DONE			0x03
+#define EMU_CMD_END_MARK		0x0F
+
+#define EMU_DCI_SIZE			0x10000U
+#define EMU_DCI_RANGE_SIZE		0x5440
+#define EMU_MAX_OUTPUTS			32U
+#define EMU_FRAME_MAX_SIZE		VL53L8CX_UI_CMD_STATUS
+#define EMU_NB_SPADS			2560U
+
+#define EMU_DEFAULT_DISTANCE_MM		1000U
+#define EMU_DEFAULT_REFLECTANCE		50U
+#define EMU_DEFAULT_AMBIENT		2U
+#define EMU_DEFAULT_TEMP_DEGC		25
+#define EMU_DEFAULT_SEED		0x5EED5EEDU
+
+typedef struct
+{
+	uint8_t page;
+	uint8_t go[EMU_PAGE_SIZE];
+	uint8_t ui[EMU_PAGE_SIZE];
+
+	/* DCI blocks, as sent on the bus (big endian words) */
+	uint8_t dci[EMU_DCI_SIZE];
+
+	/* Bytes received on the FW pages since the last reboot */
+	uint32_t fw_received;
+	uint8_t fw_running;
+
+	/* Ranging session */
+	uint8_t ranging;
+	uint32_t frame_size;
+	uint32_t nb_outputs;
+	uint32_t outputs[EMU_MAX_OUTPUTS];
+	uint32_t enables[EMU_MAX_OUTPUTS / 32U];
+	uint64_t start_us;
+	uint64_t period_us;
+	uint32_t frame;
+	uint32_t frame_buffer[EMU_FRAME_MAX_SIZE / 4U];
+
+	VL53L8CX_EmulatorScene scene;
+	VL53L8CX_EmulatorScript script;
+	void *script_user;
+	uint32_t rng;
+} VL53L8CX_Emulator;
+
+static uint32_t Emu_Random(VL53L8CX_Emulator *emu)
+{
+	/* xorshift32 */
+	emu->rng ^= emu->rng << 13;
+	emu->rng ^= emu->rng >> 17;
+	emu->rng ^= emu->rng << 5;
+	return emu->rng;
+}
+
+/*
+ * Value of a DCI block word, as seen by the host after VL53L8CX_SwapBuffer()
+ */
+static uint32_t Emu_DciWord(VL53L8CX_Emulator *emu, uint32_t index)
+{
+	uint8_t *p = &emu->dci[index];
+
+	return ((uint32_t)p[0] << 24) | ((uint32_t)p[1] << 16)
+		| ((uint32_t)p[2] << 8) | (uint32_t)p[3];
+}
+
+static void Emu_SetDciWord(VL53L8CX_Emulator *emu, uint32_t index, uint32_t value)
+{
+	uint8_t *p = &emu->dci[index];
+
+	p[0] = (uint8_t)(value >> 24);
+	p[1] = (uint8_t)(value >> 16);
+	p[2] = (uint8_t)(value >> 8);
+	p[3] = (uint8_t)value;
+}
+
+/*
+ * Size of the data following a block header: typed blocks hold 'size'
+ * elements of 'type' bytes
+ */
+static uint32_t Emu_BlockSize(uint32_t header)
+{
+	uint32_t type = header & 0xF;
+	uint32_t size = (header >> 4) & 0xFFF;
+
+	if ((type >= 0x1) && (type < 0xD))
+		return type * size;
+	return size;
+}
+
+static uint32_t Emu_Resolution(VL53L8CX_Emulator *emu)
+{
+	uint32_t zone_config = Emu_DciWord(emu, VL53L8CX_DCI_ZONE_CONFIG);
+
+	return (zone_config & 0xFF) * ((zone_config >> 8) & 0xFF);
+}
+
+/*
+ * Walk the block headers of a command, from 'start' to the end mark. Blocks
+ * are written into the DCI memory when 'write' is set, or copied with their
+ * header into the command answer otherwise.
+ */
+static void Emu_DciBlocks(VL53L8CX_Emulator *emu, uint32_t start, uint8_t write)
+{
+	uint8_t request[VL53L8CX_UI_CMD_END + 1 - VL53L8CX_UI_CMD_START];
+	uint8_t *p_header;
+	uint32_t pos, answer = VL53L8CX_UI_CMD_START, end, header, index, size;
+
+	/* The answer overwrites the request */
+	end = VL53L8CX_UI_CMD_END + 1 - 8;
+	memcpy(request, &emu->ui[start], end - start);
+
+	for (pos = 0; start + pos + 4 <= end; pos += 4 + size) {
+		p_header = &request[pos];
+		header = ((uint32_t)p_header[0] << 24) | ((uint32_t)p_header[1] << 16)
+			| ((uint32_t)p_header[2] << 8) | (uint32_t)p_header[3];
+		if (header == EMU_CMD_END_MARK)
+			break;
+
+		index = header >> 16;
+		size = Emu_BlockSize(header);
+		if (index + size > EMU_DCI_SIZE)
+			break;
+
+		if (write) {
+			if (start + pos + 4 + size > end)
+				break;
+			memcpy(&emu->dci[index], &p_header[4], size);
+		} else {
+			if (answer + 4 + size + 4 > end)
+				break;
+			memcpy(&emu->ui[answer], p_header, 4);
+			memcpy(&emu->ui[answer + 4], &emu->dci[index], size);
+			answer += 4 + size;
+			size = 0;
+		}
+	}
+
+	if (!write) {
+		memset(&emu->ui[answer], 0, 4);
+		emu->ui[answer + 3] = EMU_CMD_END_MARK;
+	}
+}
+
+/*
+ * Program the ranging session from the output list, the enabled outputs and
+ * the resolution, as the FW does. The frame size found is reported in the
+ * range data block, for the host to check it.
+ */
+static void Emu_StartRanging(VL53L8CX_Emulator *emu)
+{
+	uint32_t i, frequency_hz, nb_outputs;
+
+	nb_outputs = Emu_DciWord(emu, VL53L8CX_DCI_OUTPUT_CONFIG + 4);
+	nb_outputs = (nb_outputs > 0) ? nb_outputs - 1 : 0;
+	if (nb_outputs > EMU_MAX_OUTPUTS)
+		nb_outputs = EMU_MAX_OUTPUTS;
+
+	emu->nb_outputs = nb_outputs;
+	emu->frame_size = 32;
+	for (i = 0; i < EMU_MAX_OUTPUTS / 32U; i++)
+		emu->enables[i] = Emu_DciWord(emu, VL53L8CX_DCI_OUTPUT_ENABLES + (4 * i));
+	for (i = 0; i < nb_outputs; i++) {
+		emu->outputs[i] = Emu_DciWord(emu, VL53L8CX_DCI_OUTPUT_LIST + (4 * i));
+		if ((emu->outputs[i] == 0) || ((emu->enables[i / 32] & (1U << (i % 32))) == 0))
+			continue;
+		emu->frame_size += 4 + Emu_BlockSize(emu->outputs[i]);
+	}
+	Emu_SetDciWord(emu, EMU_DCI_RANGE_SIZE + 8, emu->frame_size);
+
+	if (emu->frame_size > EMU_FRAME_MAX_SIZE) {
+		LOG("Emulator: frame of %u bytes is too large\n", emu->frame_size);
+		return;
+	}
+
+	frequency_hz = (Emu_DciWord(emu, VL53L8CX_DCI_FREQ_HZ) >> 8) & 0xFF;
+	emu->period_us = 1000000U / ((frequency_hz != 0) ? frequency_hz : 1);
+	/* Sensor clock: the system clock is read directly, so that the
+	 * emulator time does not appear in a bus trace */
+	emu->start_us = VL53L8CX_ClockTimeUs();
+	emu->frame = 0;
+	emu->ui[0] = 0xFF;
+	emu->ranging = 1;
+}
+
+/*
+ * Answer a command, when its last byte is written into the command area
+ */
+static void Emu_Command(VL53L8CX_Emulator *emu)
+{
+	uint8_t *cmd = &emu->ui[VL53L8CX_UI_CMD_END - 3];
+	uint32_t size = ((uint32_t)cmd[2] << 8) | cmd[3];
+	uint8_t tag = cmd[0];
+	uint32_t start;
+
+	if (!emu->fw_running)
+		return;
+
+	switch (cmd[1]) {
+	case EMU_CMD_WRITE:
+	case EMU_CMD_READ:
+		if ((size < 4) || (size > VL53L8CX_UI_CMD_END + 1 - 4 - VL53L8CX_UI_CMD_START))
+			return;
+		start = VL53L8CX_UI_CMD_END + 1 - 4 - size;
+		Emu_DciBlocks(emu, start, (uint8_t)(cmd[1] == EMU_CMD_WRITE));
+		break;
+	case EMU_CMD_START:
+		Emu_StartRanging(emu);
+		break;
+	default:
+		return;
+	}
+
+	emu->ui[VL53L8CX_UI_CMD_STATUS] = tag;
+	emu->ui[VL53L8CX_UI_CMD_STATUS + 1] = EMU_CMD_DONE;
+	emu->ui[VL53L8CX_UI_CMD_STATUS + 2] = 0;
+	emu->ui[VL53L8CX_UI_CMD_STATUS + 3] = 0;
+}
+
+static void Emu_Boot(VL53L8CX_Emulator *emu)
+{
+	emu->fw_running = 1;
+	emu->ranging = 0;
+	memset(emu->ui, 0, sizeof(emu->ui));
+	memset(emu->dci, 0, sizeof(emu->dci));
+	emu->ui[EMU_FW_CHECKSUM_ADDRESS] = (uint8_t)(EMU_FW_CHECKSUM >> 24);
+	emu->ui[EMU_FW_CHECKSUM_ADDRESS + 1] = (uint8_t)(EMU_FW_CHECKSUM >> 16);
+	emu->ui[EMU_FW_CHECKSUM_ADDRESS + 2] = (uint8_t)(EMU_FW_CHECKSUM >> 8);
+	emu->ui[EMU_FW_CHECKSUM_ADDRESS + 3] = (uint8_t)EMU_FW_CHECKSUM;
+}
+
+static void Emu_WriteGo(VL53L8CX_Emulator *emu, uint16_t reg_address, uint8_t value)
+{
+	emu->go[reg_address] = value;
+
+	switch (reg_address) {
+	case 0x0F:
+		/* MCU powered down, the FW RAM is lost */
+		if (value == 0x43) {
+			emu->fw_running = 0;
+			emu->ranging = 0;
+			emu->fw_received = 0;
+		}
+		break;
+	case 0x0B:
+		/* MCU reset released, boot on the downloaded FW */
+		if ((value == 0x01) && (emu->fw_received >= EMU_FW_SIZE))
+			Emu_Boot(emu);
+		break;
+	case 0x14:
+		/* MCU stop */
+		if ((value == 0x01) && (emu->go[0x15] == 0x16))
+			emu->ranging = 0;
+		break;
+	default:
+		break;
+	}
+}
+
+static uint8_t Emu_ReadGo(VL53L8CX_Emulator *emu, uint16_t reg_address)
+{
+	switch (reg_address) {
+	case 0x00:
+		return EMU_DEVICE_ID;
+	case 0x01:
+		return EMU_REVISION_ID;
+	case 0x06:
+		/* GO2 status 0: bit 0 awake, bit 7 MCU idle */
+		return (uint8_t)(((emu->go[0x09] != 0x02) ? 0x01 : 0x00)
+			| ((emu->fw_running && !emu->ranging) ? 0x80 : 0x00));
+	case 0x07:
+		/* GO2 status 1 */
+		return emu->fw_running ? 0x85 : 0x00;
+	default:
+		return emu->go[reg_address];
+	}
+}
+
+/*
+ * Fill a block of the frame, in the FW format
+ */
+static void Emu_FillBlock(VL53L8CX_Emulator *emu, uint8_t *data, uint32_t header,
+		uint32_t resolution, const uint16_t *distance_mm)
+{
+	VL53L8CX_EmulatorScene *scene = &emu->scene;
+	uint32_t type = header & 0xF, nb = (header >> 4) & 0xFFF;
+	uint32_t e, zone, target, targets, z, d, signal;
+	uint16_t v16;
+	uint32_t v32;
+	uint8_t v8;
+
+	if ((header >> 16) == VL53L8CX_METADATA_IDX) {
+		data[8] = (uint8_t)scene->silicon_temp_degc;
+		return;
+	}
+	if ((type < 0x1) || (type >= 0xD) || (resolution == 0))
+		return;
+
+	targets = (nb >= resolution) ? nb / resolution : 1;
+	for (e = 0; e < nb; e++) {
+		zone = e / targets;
+		target = e % targets;
+		if (resolution == 16)
+			z = ((zone / 4) * 16) + ((zone % 4) * 2);
+		else
+			z = zone % VL53L8CX_EMULATOR_NB_ZONES;
+		d = (target == 0) ? distance_mm[z] : 0;
+		signal = (d == 0) ? 0 : (((uint32_t)scene->reflectance_percent[z] * 100000U)
+			/ (((d / 10) * (d / 10)) + 1));
+
+		v32 = 0;
+		switch (header >> 16) {
+		case VL53L8CX_AMBIENT_RATE_IDX:
+			v32 = scene->ambient_kcps_per_spad * 2048U;
+			break;
+		case VL53L8CX_SPAD_COUNT_IDX:
+			v32 = EMU_NB_SPADS;
+			break;
+		case VL53L8CX_NB_TARGET_DETECTED_IDX_1T:
+		case VL53L8CX_NB_TARGET_DETECTED_IDX_NT:
+			v32 = (distance_mm[z] != 0) ? 1 : 0;
+			break;
+		case VL53L8CX_SIGNAL_RATE_IDX_1T:
+		case VL53L8CX_SIGNAL_RATE_IDX_NT:
+			v32 = signal * 2048U;
+			break;
+		case VL53L8CX_RANGE_SIGMA_MM_IDX_1T:
+		case VL53L8CX_RANGE_SIGMA_MM_IDX_NT:
+			v32 = (d == 0) ? 0 : ((uint32_t)scene->noise_mm + 1) * 128U;
+			break;
+		case VL53L8CX_DISTANCE_IDX_1T:
+		case VL53L8CX_DISTANCE_IDX_NT:
+			v32 = d * 4U;
+			break;
+		case VL53L8CX_REFLECTANCE_EST_PC_IDX_1T:
+		case VL53L8CX_REFLECTANCE_EST_PC_IDX_NT:
+			v32 = (d == 0) ? 0 : (uint32_t)scene->reflectance_percent[z] * 2U;
+			break;
+		case VL53L8CX_TARGET_STATUS_IDX_1T:
+		case VL53L8CX_TARGET_STATUS_IDX_NT:
+			v32 = (d == 0) ? 0 : 5;
+			break;
+		default:
+			break;
+		}
+
+		switch (type) {
+		case 1:
+			v8 = (uint8_t)v32;
+			memcpy(&data[e], &v8, 1);
+			break;
+		case 2:
+			v16 = (uint16_t)v32;
+			memcpy(&data[e * 2], &v16, 2);
+			break;
+		case 4:
+			memcpy(&data[e * 4], &v32, 4);
+			break;
+		default:
+			break;
+		}
+	}
+}
+
+/*
+ * Build the frame of the current period into the UI RAM. The frame holds the
+ * status word read by vl53l8cx_check_data_ready(), a header, the enabled
+ * blocks in the order of the output list, and a footer block holding the
+ * footer id and the CRC.
+ */
+static void Emu_UpdateFrame(VL53L8CX_Emulator *emu)
+{
+	VL53L8CX_EmulatorScene *scene = &emu->scene;
+	uint8_t *frame = (uint8_t *)emu->frame_buffer;
+	uint16_t distance_mm[VL53L8CX_EMULATOR_NB_ZONES];
+	uint32_t i, pos, header, size, frame_id, resolution, crc;
+	uint32_t *words = emu->frame_buffer;
+	uint64_t number;
+	int32_t d;
+
+	number = (VL53L8CX_ClockTimeUs() - emu->start_us) / emu->period_us;
+	if ((number == 0) || (number == emu->frame))
+		return;
+	emu->frame = (uint32_t)number;
+
+	if (emu->script != NULL)
+		emu->script(scene, emu->frame, emu->script_user);
+
+	/* Frame skipped by the sensor */
+	if ((Emu_Random(emu) % 100U) < scene->drop_percent)
+		return;
+
+	for (i = 0; i < VL53L8CX_EMULATOR_NB_ZONES; i++) {
+		d = scene->distance_mm[i];
+		if ((d != 0) && (scene->noise_mm != 0))
+			d += (int32_t)(Emu_Random(emu) % (2U * scene->noise_mm + 1U)) - scene->noise_mm;
+		distance_mm[i] = (scene->distance_mm[i] == 0) ? 0 : (uint16_t)((d < 1) ? 1 : d);
+	}
+
+	resolution = Emu_Resolution(emu);
+	frame_id = emu->frame & 0xFFFF;
+	memset(frame, 0, emu->frame_size);
+
+	/* Stream count (0 to 254), and data ready flags */
+	words[0] = ((emu->frame % 255U) << 24) | (0x05 << 16) | (0x05 << 8) | 0x10;
+	words[2] = frame_id;
+
+	pos = 12;
+	for (i = 0; i < emu->nb_outputs; i++) {
+		header = emu->outputs[i];
+		if ((header == 0) || ((emu->enables[i / 32] & (1U << (i % 32))) == 0))
+			continue;
+		size = Emu_BlockSize(header);
+		words[pos / 4] = header;
+		Emu_FillBlock(emu, &frame[pos + 4], header, resolution, distance_mm);
+		pos += 4 + size;
+	}
+
+	/* Footer block */
+	words[pos / 4] = 16 << 4;
+	words[(emu->frame_size - 12) / 4] = frame_id;
+	if (emu->dci[VL53L8CX_DCI_CRC_RESULTS_PKT + 6] != 0) {
+		crc = 0;
+		for (i = 0; i < (emu->frame_size - 12) / 4; i++)
+			crc ^= words[1 + i] + i;
+		words[(emu->frame_size - 8) / 4] = crc;
+	}
+
+	/* Corrupted after the CRC, like a frame overwritten during the read */
+	if ((Emu_Random(emu) % 100U) < scene->corrupt_percent)
+		words[(emu->frame_size - 12) / 4] = ~frame_id & 0xFFFF;
+
+	memcpy(emu->ui, frame, emu->frame_size);
+	VL53L8CX_SwapBuffer(emu->ui, (uint16_t)emu->frame_size);
+}
+
+/*
+ * Number of bytes of an access which fall inside a page, below the page
+ * register
+ */
+static uint32_t Emu_Clamp(uint16_t reg_address, uint32_t count)
+{
+	if (reg_address >= EMU_PAGE_REGISTER)
+		return 0;
+	if (reg_address + count > EMU_PAGE_REGISTER)
+		return EMU_PAGE_REGISTER - reg_address;
+	return count;
+}
+
+static void Emu_Write(VL53L8CX_Emulator *emu, uint16_t reg_address,
+		uint8_t *p_data, uint32_t count)
+{
+	uint32_t i;
+
+	if (reg_address == EMU_PAGE_REGISTER) {
+		emu->page = p_data[0];
+		return;
+	}
+
+	/* The FW image is only counted, a FW page is written in one access */
+	if ((emu->page >= EMU_PAGE_FW_FIRST) && (emu->page <= EMU_PAGE_FW_LAST)) {
+		emu->fw_received += count;
+		return;
+	}
+
+	count = Emu_Clamp(reg_address, count);
+	if (emu->page == EMU_PAGE_GO) {
+		for (i = 0; i < count; i++)
+			Emu_WriteGo(emu, (uint16_t)(reg_address + i), p_data[i]);
+	} else if (emu->page == EMU_PAGE_UI) {
+		memcpy(&emu->ui[reg_address], p_data, count);
+		if ((reg_address <= VL53L8CX_UI_CMD_END) && (reg_address + count > VL53L8CX_UI_CMD_END))
+			Emu_Command(emu);
+	}
+}
+
+static void Emu_Read(VL53L8CX_Emulator *emu, uint16_t reg_address,
+		uint8_t *p_data, uint32_t count)
+{
+	uint32_t i;
+
+	if (reg_address == EMU_PAGE_REGISTER) {
+		memset(p_data, 0, count);
+		p_data[0] = emu->page;
+		return;
+	}
+	memset(p_data, 0, count);
+	count = Emu_Clamp(reg_address, count);
+
+	if (emu->page == EMU_PAGE_GO) {
+		for (i = 0; i < count; i++)
+			p_data[i] = Emu_ReadGo(emu, (uint16_t)(reg_address + i));
+	} else if (emu->page == EMU_PAGE_FW_ACCESS) {
+		for (i = 0; i < count; i++)
+			p_data[i] = (reg_address + i == 0x21) ? 0x04 : 0x00;
+	} else if (emu->page == EMU_PAGE_UI) {
+		if (emu->ranging && (reg_address < emu->frame_size))
+			Emu_UpdateFrame(emu);
+		memcpy(p_data, &emu->ui[reg_address], count);
+	}
+}
+
+static int32_t Emulator_Submit(VL53L8CX_Platform *p_platform, VL53L8CX_Access *accesses, uint16_t nb_accesses)
+{
+	VL53L8CX_Emulator *emu = (VL53L8CX_Emulator *)p_platform->transport_data;
+	uint16_t i;
+
+	for (i = 0; i < nb_accesses; i++) {
+		if (accesses[i].write_not_read)
+			Emu_Write(emu, accesses[i].reg_address,
+				accesses[i].p_data, accesses[i].count);
+		else
+			Emu_Read(emu, accesses[i].reg_address,
+				accesses[i].p_data, accesses[i].count);
+	}
+
+	return 0;
+}
+
+static void Emulator_Close(VL53L8CX_Platform *p_platform)
+{
+	free(p_platform->transport_data);
+	p_platform->transport_data = NULL;
+}
+
+static int32_t Emulator_Open(VL53L8CX_Platform *p_platform)
+{
+	VL53L8CX_Emulator *emu;
+	uint32_t i;
+
+	p_platform->fd = -1;
+	emu = calloc(1, sizeof(VL53L8CX_Emulator));
+	p_platform->transport_data = emu;
+	if (emu == NULL) {
+		LOG("Could not allocate the emulated sensor\n");
+		return VL53L8CX_COMMS_ERROR;
+	}
+
+	/* Powered on and awake, FW not downloaded */
+	emu->go[0x09] = 0x04;
+	emu->rng = EMU_DEFAULT_SEED;
+	for (i = 0; i < VL53L8CX_EMULATOR_NB_ZONES; i++) {
+		emu->scene.distance_mm[i] = EMU_DEFAULT_DISTANCE_MM;
+		emu->scene.reflectance_percent[i] = EMU_DEFAULT_REFLECTANCE;
+	}
+	emu->scene.ambient_kcps_per_spad = EMU_DEFAULT_AMBIENT;
+	emu->scene.silicon_temp_degc = EMU_DEFAULT_TEMP_DEGC;
+
+	return 0;
+}
+
+/*
+ * Emulator of a device, used directly or through the bus recorder
+ */
+static VL53L8CX_Emulator *Emu_Get(VL53L8CX_Platform *p_platform)
+{
+	if ((p_platform->transport == &VL53L8CX_EmulatorTransport)
+		|| ((p_platform->transport == &VL53L8CX_RecorderTransport)
+			&& (p_platform->trace_transport == &VL53L8CX_EmulatorTransport)))
+		return (VL53L8CX_Emulator *)p_platform->transport_data;
+	return NULL;
+}
+
+uint8_t VL53L8CX_EmulatorSetScene(
+		VL53L8CX_Platform *p_platform,
+		const VL53L8CX_EmulatorScene *p_scene)
+{
+	VL53L8CX_Emulator *emu = Emu_Get(p_platform);
+
+	if (emu == NULL)
+		return VL53L8CX_STATUS_ERROR;
+
+	emu->scene = *p_scene;
+	if (p_scene->seed != 0)
+		emu->rng = p_scene->seed;
+
+	return VL53L8CX_STATUS_OK;
+}
+
+uint8_t VL53L8CX_EmulatorSetScript(
+		VL53L8CX_Platform *p_platform,
+		VL53L8CX_EmulatorScript script,
+		void *p_user)
+{
+	VL53L8CX_Emulator *emu = Emu_Get(p_platform);
+
+	if (emu == NULL)
+		return VL53L8CX_STATUS_ERROR;
+
+	emu->script = script;
+	emu->script_user = p_user;
+
+	return VL53L8CX_STATUS_OK;
+}
+
+const VL53L8CX_Transport VL53L8CX_EmulatorTransport = {
+	.name = "emulator",
+	.open = Emulator_Open,
+	.close = Emulator_Close,
+	.submit = Emulator_Submit,
+	.wait_interrupt = NULL,
+	.get_time_us = NULL,
+	.sleep_until = NULL,
+};
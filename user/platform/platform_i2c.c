@@ -0,0 +1,190 @@
+/**
+  *
+  * Copyright (c) 2023 STMicroelectronics.
+  * All rights reserved.
+  *
+  * This software is licensed under terms that can be found in the LICENSE file
+  * in the root directory of this software component.
+  * If no LICENSE file comes with this software, it is provided AS-IS.
+  *
+  ******************************************************************************
+  */
+
+#include <fcntl.h> // open()
+#include <unistd.h> // close()
+#include <errno.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include <linux/i2c.h>
+#include <linux/i2c-dev.h>
+
+#include <sys/ioctl.h>
+
+#include "platform.h"
+
+#define VL53L8CX_COMMS_ERROR		-2
+
+#define VL53L8CX_I2C_DEFAULT_DEVICE "/dev/i2c-1"
+#define VL53L8CX_I2C_DEV_MAX_LEN   8192 // i2c-dev limit for one I2C_RDWR message
+#define VL53L8CX_I2C_MIN_LEN       32
+/* Large enough to pack a full 32 KiB firmware page in one I2C_RDWR */
+#define VL53L8CX_I2C_BATCH_SIZE    (0x8000 + (2 * I2C_RDWR_IOCTL_MAX_MSGS))
+
+#define LOG 				printf
+
+static void I2C_Close(VL53L8CX_Platform *p_platform)
+{
+	free(p_platform->i2c_msgs);
+	free(p_platform->i2c_buffer);
+	p_platform->i2c_msgs = NULL;
+	p_platform->i2c_buffer = NULL;
+	close(p_platform->fd);
+}
+
+static int32_t I2C_Open(VL53L8CX_Platform *p_platform)
+{
+	const char *devname = (p_platform->device[0] != '\0') ? p_platform->device : VL53L8CX_I2C_DEFAULT_DEVICE;
+	unsigned long funcs = 0;
+
+	p_platform->i2c_msgs = NULL;
+	p_platform->i2c_buffer = NULL;
+
+	/* Create sensor at default i2c address */
+	if (p_platform->address == 0)
+		p_platform->address = 0x52;
+	p_platform->fd = open(devname, O_RDONLY);
+	if (p_platform->fd == -1) {
+		LOG("Failed to open %s\n", devname);
+		return VL53L8CX_COMMS_ERROR;
+	}
+
+	if (ioctl(p_platform->fd, I2C_SLAVE, p_platform->address) <0) {
+		LOG("Could not speak to the device on the i2c bus\n");
+		I2C_Close(p_platform);
+		return VL53L8CX_COMMS_ERROR;
+	}
+
+	if ((ioctl(p_platform->fd, I2C_FUNCS, &funcs) < 0)
+		|| ((funcs & I2C_FUNC_I2C) == 0)) {
+		LOG("Adapter does not support I2C_RDWR transfers\n");
+		I2C_Close(p_platform);
+		return VL53L8CX_COMMS_ERROR;
+	}
+
+	/* The adapter limits (quirks) are not exposed to user space: start from
+	 * the i2c-dev limits, I2C_Transfer() lowers them if the adapter rejects
+	 * a transfer */
+	p_platform->i2c_max_len = VL53L8CX_I2C_DEV_MAX_LEN;
+	p_platform->i2c_max_msgs = I2C_RDWR_IOCTL_MAX_MSGS;
+	p_platform->i2c_msgs = malloc(I2C_RDWR_IOCTL_MAX_MSGS * sizeof(struct i2c_msg));
+	p_platform->i2c_buffer = malloc(VL53L8CX_I2C_BATCH_SIZE);
+	if ((p_platform->i2c_msgs == NULL) || (p_platform->i2c_buffer == NULL)) {
+		LOG("Could not allocate I2C transfer buffers\n");
+		I2C_Close(p_platform);
+		return VL53L8CX_COMMS_ERROR;
+	}
+
+	return 0;
+}
+
+/*
+ * Transfer a list of register accesses, packing as many chunks as possible into
+ * each I2C_RDWR call. Write chunks are staged with their register index, read
+ * chunks land directly in the caller buffer.
+ */
+static int32_t I2C_Transfer(VL53L8CX_Platform *p_platform, VL53L8CX_Access *accesses, uint16_t nb_accesses)
+{
+	struct i2c_rdwr_ioctl_data packets;
+	struct i2c_msg *messages = (struct i2c_msg *)p_platform->i2c_msgs;
+	VL53L8CX_Access *access;
+	uint8_t *buffer;
+	uint32_t data_size, position = 0, batch_position, staged;
+	uint32_t nb_msgs;
+	uint16_t index = 0, batch_index;
+
+	while (index < nb_accesses) {
+		batch_index = index;
+		batch_position = position;
+		nb_msgs = 0;
+		staged = 0;
+
+		while (index < nb_accesses) {
+			access = &accesses[index];
+			if (access->write_not_read) {
+				data_size = (access->count - position) > (uint32_t)(p_platform->i2c_max_len - 2) ? (uint32_t)(p_platform->i2c_max_len - 2) : (access->count - position);
+				if ((nb_msgs + 1 > p_platform->i2c_max_msgs)
+					|| (staged + data_size + 2 > VL53L8CX_I2C_BATCH_SIZE))
+					break;
+			} else {
+				data_size = (access->count - position) > p_platform->i2c_max_len ? p_platform->i2c_max_len : (access->count - position);
+				if ((nb_msgs + 2 > p_platform->i2c_max_msgs)
+					|| (staged + 2 > VL53L8CX_I2C_BATCH_SIZE))
+					break;
+			}
+
+			buffer = &p_platform->i2c_buffer[staged];
+			buffer[0] = (access->reg_address + position) >> 8;
+			buffer[1] = (access->reg_address + position) & 0xFF;
+
+			messages[nb_msgs].addr = p_platform->address >> 1;
+			messages[nb_msgs].flags = 0; //I2C_M_WR;
+			messages[nb_msgs].buf = buffer;
+
+			if (access->write_not_read) {
+				memcpy(&buffer[2], &access->p_data[position], data_size);
+				messages[nb_msgs].len = data_size + 2;
+				staged += data_size + 2;
+				nb_msgs++;
+			} else {
+				messages[nb_msgs].len = 2;
+				messages[nb_msgs + 1].addr = p_platform->address >> 1;
+				messages[nb_msgs + 1].flags = I2C_M_RD;
+				messages[nb_msgs + 1].len = data_size;
+				messages[nb_msgs + 1].buf = access->p_data + position;
+				staged += 2;
+				nb_msgs += 2;
+			}
+
+			position += data_size;
+			if (position >= access->count) {
+				position = 0;
+				index++;
+			}
+		}
+
+		packets.msgs = messages;
+		packets.nmsgs = nb_msgs;
+
+		if (ioctl(p_platform->fd, I2C_RDWR, &packets) < 0) {
+			/* Adapter quirks are checked before anything goes on the
+			 * bus: lower the limits and send this batch again */
+			if ((errno != EOPNOTSUPP) && (errno != EINVAL))
+				return VL53L8CX_COMMS_ERROR;
+
+			if ((nb_msgs > 2) && (p_platform->i2c_max_msgs > 2))
+				p_platform->i2c_max_msgs = 2;
+			else if (p_platform->i2c_max_len > VL53L8CX_I2C_MIN_LEN)
+				p_platform->i2c_max_len /= 2;
+			else
+				return VL53L8CX_COMMS_ERROR;
+
+			LOG("I2C_Transfer: adapter limits lowered to %u msgs of %u bytes\n",
+				p_platform->i2c_max_msgs, p_platform->i2c_max_len);
+			index = batch_index;
+			position = batch_position;
+		}
+	}
+
+	return 0;
+}
+
+const VL53L8CX_Transport VL53L8CX_I2cTransport = {
+	.name = "i2c-dev",
+	.open = I2C_Open,
+	.close = I2C_Close,
+	.submit = I2C_Transfer,
+	.wait_interrupt = NULL,
+	.get_time_us = NULL,
+	.sleep_until = NULL,
+};
@@ -0,0 +1,154 @@
+/**
+  *
+  * Copyright (c) 2023 STMicroelectronics.
+  * All rights reserved.
+  *
+  * This software is licensed under terms that can be found in the LICENSE file
+  * in the root directory of this software component.
+  * If no LICENSE file comes with this software, it is provided AS-IS.
+  *
+  ******************************************************************************
+  */
+
+#include <fcntl.h> // open()
+#include <unistd.h> // close()
+#include <errno.h>
+#include <stdio.h>
+
+#include <sys/ioctl.h>
+
+#include "platform.h"
+
+#define VL53L8CX_COMMS_ERROR		-2
+
+#define VL53L8CX_KERNEL_DEFAULT_DEVICE "/dev/stmvl53l8cx"
+
+#define LOG 				printf
+
+struct comms_struct {
+	uint16_t   len;
+	uint16_t   reg_address;
+	uint8_t    write_not_read;
+	uint8_t    padding[3]; /* 64bits alignment */
+	uint64_t   bufptr;
+};
+
+/* Array of comms_struct executed in order by the kernel module */
+struct comms_batch_struct {
+	uint32_t   nb_transfers;
+	uint32_t   padding; /* 64bits alignment */
+	uint64_t   transfers;
+};
+
+/* Absolute CLOCK_MONOTONIC time at which the interrupt wait gives up */
+struct wait_deadline_struct {
+	uint64_t   deadline_ns;
+};
+
+#define ST_TOF_IOCTL_TRANSFER           _IOWR('a',0x1, struct comms_struct)
+#define ST_TOF_IOCTL_WAIT_FOR_INTERRUPT	_IO('a',0x2)
+#define ST_TOF_IOCTL_TRANSFER_BATCH	_IOW('a',0x3, struct comms_batch_struct)
+#define ST_TOF_IOCTL_WAIT_FOR_INTERRUPT_DEADLINE	_IOW('a',0x4, struct wait_deadline_struct)
+
+static int32_t Kernel_Open(VL53L8CX_Platform *p_platform)
+{
+	const char *devname = (p_platform->device[0] != '\0') ? p_platform->device : VL53L8CX_KERNEL_DEFAULT_DEVICE;
+
+	p_platform->fd = open(devname, O_RDONLY);
+	if (p_platform->fd == -1) {
+		LOG("Failed to open %s\n", devname);
+		return VL53L8CX_COMMS_ERROR;
+	}
+	p_platform->no_batch_ioctl = 0;
+	p_platform->no_wait_deadline_ioctl = 0;
+
+	return 0;
+}
+
+static void Kernel_Close(VL53L8CX_Platform *p_platform)
+{
+	close(p_platform->fd);
+}
+
+/*
+ * Send a list of register accesses, as one ST_TOF_IOCTL_TRANSFER_BATCH when
+ * the module supports it
+ */
+static int32_t Kernel_Submit(
+		VL53L8CX_Platform * p_platform,
+		VL53L8CX_Access *accesses,
+		uint16_t nb_accesses)
+{
+	struct comms_struct cs[VL53L8CX_TR_MAX_ACCESSES];
+	struct comms_batch_struct batch;
+	uint16_t i;
+
+	for (i = 0; i < nb_accesses; i++) {
+		cs[i].len = accesses[i].count;
+		cs[i].reg_address = accesses[i].reg_address;
+		cs[i].bufptr = (uint64_t)(uintptr_t)accesses[i].p_data;
+		cs[i].write_not_read = accesses[i].write_not_read;
+	}
+
+	if ((nb_accesses > 1) && !p_platform->no_batch_ioctl) {
+		batch.nb_transfers = nb_accesses;
+		batch.padding = 0;
+		batch.transfers = (uint64_t)(uintptr_t)cs;
+
+		if (ioctl(p_platform->fd, ST_TOF_IOCTL_TRANSFER_BATCH, &batch) == 0)
+			return 0;
+
+		/* Older modules reject the command before any transfer */
+		if ((errno != EINVAL) && (errno != ENOTTY))
+			return VL53L8CX_COMMS_ERROR;
+
+		LOG("Kernel_Submit: no batch support in kernel module\n");
+		p_platform->no_batch_ioctl = 1;
+	}
+
+	for (i = 0; i < nb_accesses; i++) {
+		if (ioctl(p_platform->fd, ST_TOF_IOCTL_TRANSFER, &cs[i]) < 0)
+			return VL53L8CX_COMMS_ERROR;
+	}
+
+	return 0;
+}
+
+static int32_t Kernel_WaitInterrupt(
+		VL53L8CX_Platform * p_platform,
+		uint64_t deadline_us)
+{
+	struct wait_deadline_struct wait;
+
+	if (deadline_us == 0) {
+		if (ioctl(p_platform->fd, ST_TOF_IOCTL_WAIT_FOR_INTERRUPT) < 0)
+			return -1;
+		return 1;
+	}
+
+	if (p_platform->no_wait_deadline_ioctl)
+		return -2;
+
+	wait.deadline_ns = deadline_us * 1000;
+	if (ioctl(p_platform->fd, ST_TOF_IOCTL_WAIT_FOR_INTERRUPT_DEADLINE, &wait) == 0)
+		return 1;
+	if (errno == ETIMEDOUT)
+		return 0;
+	if ((errno != ENOTTY) && (errno != EINVAL))
+		return -1;
+
+	/* Older kernel module: poll the sensor instead */
+	LOG("ST_TOF_IOCTL_WAIT_FOR_INTERRUPT_DEADLINE not supported, polling data ready\n");
+	p_platform->no_wait_deadline_ioctl = 1;
+	return -2;
+}
+
+const VL53L8CX_Transport VL53L8CX_KernelTransport = {
+	.name = "stmvl53l8cx",
+	.open = Kernel_Open,
+	.close = Kernel_Close,
+	.submit = Kernel_Submit,
+	.wait_interrupt = Kernel_WaitInterrupt,
+	.get_time_us = NULL,
+	.sleep_until = NULL,
+};
@@ -0,0 +1,267 @@
+/**
+  *
+  * Copyright (c) 2023 STMicroelectronics.
+  * All rights reserved.
+  *
+  * This software is licensed under terms that can be found in the LICENSE file
+  * in the root directory of this software component.
+  * If no LICENSE file comes with this software, it is provided AS-IS.
+  *
+  ******************************************************************************
+  */
+
+#include <fcntl.h> // open()
+#include <unistd.h> // close()
+#include <stdio.h>
+#include <stdlib.h>
+
+#include <linux/spi/spidev.h>
+
+#include <sys/ioctl.h>
+
+#include "platform.h"
+
+#define VL53L8CX_COMMS_ERROR		-2
+
+#define VL53L8CX_SPIDEV_BUFSIZ_PARAM  "/sys/module/spidev/parameters/bufsiz"
+#define VL53L8CX_SPIDEV_DEFAULT_BUFSIZ 4096 // spidev default when the parameter can't be read
+#define VL53L8CX_SPIDEV_DMA_ALIGN  128 // spidev rounds every transfer up to ARCH_DMA_MINALIGN
+#define VL53L8CX_SPI_MAX_XFERS     64  // 32 register accesses per SPI_IOC_MESSAGE
+#define VL53L8CX_CACHE_LINE_SIZE   64
+			 
+#define VL53L8CX_SPI_MODE  SPI_MODE_0
+#define VL53L8CX_SPI_SPEED_HZ  2000000
+#define VL53L8CX_SPI_NB_BITS   8
+
+#define LOG 				printf
+
+static void SPI_Close(VL53L8CX_Platform *p_platform)
+{
+	free(p_platform->spi_xfers);
+	free(p_platform->spi_headers);
+	p_platform->spi_xfers = NULL;
+	p_platform->spi_headers = NULL;
+	close(p_platform->fd);
+}
+
+static int32_t SPI_Open(VL53L8CX_Platform *p_platform)
+{
+	uint8_t spi_mode = VL53L8CX_SPI_MODE;
+	uint8_t bits = VL53L8CX_SPI_NB_BITS;
+	uint32_t speed = VL53L8CX_SPI_SPEED_HZ;
+	char devname[VL53L8CX_DEVICE_NAME_SIZE];
+	FILE *param;
+
+	p_platform->spi_xfers = NULL;
+	p_platform->spi_headers = NULL;
+
+	if (p_platform->device[0] != '\0')
+		snprintf(devname, sizeof(devname), "%s", p_platform->device);
+	else
+		snprintf(devname, sizeof(devname), "/dev/spidev%d.%d", p_platform->spi_num, p_platform->spi_cs);
+	p_platform->fd = open(devname, O_RDWR);
+	if (p_platform->fd == -1) {
+		LOG("Failed to open %s\n", devname);
+		return VL53L8CX_COMMS_ERROR;
+	}
+	else
+		LOG("Opened SPI %s\n", devname);
+
+	if (ioctl(p_platform->fd, SPI_IOC_WR_MODE, &spi_mode) <0) {
+		LOG("Could not program clock phase and polarity (WR)\n");
+		SPI_Close(p_platform);
+		return VL53L8CX_COMMS_ERROR;
+	}
+
+	if (ioctl(p_platform->fd, SPI_IOC_RD_MODE, &spi_mode) <0) {
+		LOG("Could not program clock phase and polarity (RD)\n");
+		SPI_Close(p_platform);
+		return VL53L8CX_COMMS_ERROR;
+	}
+
+	if (ioctl(p_platform->fd, SPI_IOC_WR_BITS_PER_WORD, &bits) <0) {
+		LOG("Could not program bits per words (WR)\n");
+		SPI_Close(p_platform);
+		return VL53L8CX_COMMS_ERROR;
+	}
+
+	if (ioctl(p_platform->fd, SPI_IOC_RD_BITS_PER_WORD, &bits) <0) {
+		LOG("Could not program bits per words (RD)\n");
+		SPI_Close(p_platform);
+		return VL53L8CX_COMMS_ERROR;
+	}
+
+	if (ioctl(p_platform->fd, SPI_IOC_WR_MAX_SPEED_HZ, &speed) <0) {
+		LOG("Could not program speed (WR)\n");
+		SPI_Close(p_platform);
+		return VL53L8CX_COMMS_ERROR;
+	}
+
+	if (ioctl(p_platform->fd, SPI_IOC_RD_MAX_SPEED_HZ, &speed) <0) {
+		LOG("Could not program speed (RD)\n");
+		SPI_Close(p_platform);
+		return VL53L8CX_COMMS_ERROR;
+	}
+
+	/* spidev refuses any message larger than its bufsiz parameter, which
+	 * is often raised (spidev.bufsiz=...) to speed up large transfers */
+	p_platform->spi_bufsiz = VL53L8CX_SPIDEV_DEFAULT_BUFSIZ;
+	param = fopen(VL53L8CX_SPIDEV_BUFSIZ_PARAM, "r");
+	if (param != NULL) {
+		if ((fscanf(param, "%u", &p_platform->spi_bufsiz) != 1)
+			|| (p_platform->spi_bufsiz <= 2 * VL53L8CX_SPIDEV_DMA_ALIGN))
+			p_platform->spi_bufsiz = VL53L8CX_SPIDEV_DEFAULT_BUFSIZ;
+		fclose(param);
+	}
+	LOG("SPI bufsiz = %u\n", p_platform->spi_bufsiz);
+
+	/* Transfer descriptors and index headers are allocated once per device
+	 * so that register accesses never go through the heap */
+	if (posix_memalign(&p_platform->spi_xfers, VL53L8CX_CACHE_LINE_SIZE,
+			VL53L8CX_SPI_MAX_XFERS * sizeof(struct spi_ioc_transfer)) != 0
+		|| posix_memalign((void **)&p_platform->spi_headers,
+			VL53L8CX_CACHE_LINE_SIZE, VL53L8CX_SPI_MAX_XFERS) != 0) {
+		LOG("Could not allocate SPI transfer descriptors\n");
+		SPI_Close(p_platform);
+		return VL53L8CX_COMMS_ERROR;
+	}
+	p_platform->spi_nb_xfers = 0;
+
+	return 0;
+}
+
+static uint32_t SPI_Aligned(uint32_t len)
+{
+	return (len + VL53L8CX_SPIDEV_DMA_ALIGN - 1) & ~(uint32_t)(VL53L8CX_SPIDEV_DMA_ALIGN - 1);
+}
+
+/*
+ * Submit the pending transfers as a single SPI_IOC_MESSAGE(N)
+ */
+static int32_t SPI_Flush(VL53L8CX_Platform *p_platform)
+{
+	int32_t error;
+	uint16_t nb_xfers = p_platform->spi_nb_xfers;
+
+	if (nb_xfers == 0)
+		return 0;
+
+	p_platform->spi_nb_xfers = 0;
+	p_platform->spi_tx_total = 0;
+	p_platform->spi_rx_total = 0;
+
+	error = ioctl(p_platform->fd, SPI_IOC_MESSAGE(nb_xfers), p_platform->spi_xfers);
+	if (error < 0) {
+		LOG("SPI_Flush: linux spi error (%d): %d transfers\n", error, nb_xfers);
+		return error;
+	}
+
+	return 0;
+}
+
+/*
+ * Queue one register access: the 2 bytes index then the data, with NCS low
+ * throughout. NCS is released between two queued accesses. The data is
+ * transferred from/to the caller buffer, which must stay valid until
+ * SPI_Flush().
+ */
+static int32_t SPI_Queue(VL53L8CX_Platform *p_platform, uint16_t index, uint8_t *data, uint32_t size, int write_not_read)
+{
+	struct spi_ioc_transfer *xfers;
+	uint8_t *header;
+	uint32_t tx_len, rx_len;
+	uint16_t n;
+
+	tx_len = SPI_Aligned(2) + (write_not_read ? SPI_Aligned(size) : 0);
+	rx_len = write_not_read ? 0 : SPI_Aligned(size);
+
+	if ((p_platform->spi_nb_xfers + 2 > VL53L8CX_SPI_MAX_XFERS)
+		|| (p_platform->spi_tx_total + tx_len > p_platform->spi_bufsiz)
+		|| (p_platform->spi_rx_total + rx_len > p_platform->spi_bufsiz)) {
+		if (SPI_Flush(p_platform) != 0)
+			return -1;
+	}
+
+	xfers = (struct spi_ioc_transfer *)p_platform->spi_xfers;
+	n = p_platform->spi_nb_xfers;
+	header = &p_platform->spi_headers[n];
+
+	if (write_not_read) {
+		header[0] = (uint8_t)(((index & 0xFF00) >> 8) | 0x80);
+	} else {
+		/* clear top bit of index - bit 15 is 0 for a read operation on this protocol */
+		header[0] = (uint8_t)((index & 0x7F00) >> 8);
+	}
+	header[1] = (uint8_t)(index & 0xFF);
+
+	/* Release NCS after the previous access of the same message */
+	if (n > 0)
+		xfers[n - 1].cs_change = 1;
+
+	memset(&xfers[n], 0, 2 * sizeof(struct spi_ioc_transfer));
+	xfers[n].tx_buf = (unsigned long)header;
+	xfers[n].len = 2;
+	xfers[n].speed_hz = VL53L8CX_SPI_SPEED_HZ;
+	xfers[n].bits_per_word = VL53L8CX_SPI_NB_BITS;
+
+	if (write_not_read)
+		xfers[n + 1].tx_buf = (unsigned long)data;
+	else
+		xfers[n + 1].rx_buf = (unsigned long)data;
+	xfers[n + 1].len = size;
+	xfers[n + 1].speed_hz = VL53L8CX_SPI_SPEED_HZ;
+	xfers[n + 1].bits_per_word = VL53L8CX_SPI_NB_BITS;
+
+	p_platform->spi_nb_xfers = n + 2;
+	p_platform->spi_tx_total += tx_len;
+	p_platform->spi_rx_total += rx_len;
+
+	return 0;
+}
+
+/*
+ * Send a list of register accesses, chunked to the spidev buffer size
+ */
+static int32_t SPI_Submit(
+		VL53L8CX_Platform * p_platform,
+		VL53L8CX_Access *accesses,
+		uint16_t nb_accesses)
+{
+	uint32_t data_size = 0;
+	uint32_t position = 0;
+	uint32_t chunk_size = (p_platform->spi_bufsiz - VL53L8CX_SPIDEV_DMA_ALIGN)
+			& ~(uint32_t)(VL53L8CX_SPIDEV_DMA_ALIGN - 1);
+	uint16_t i;
+
+	/* All the chunks of all the accesses go out in as few SPI_IOC_MESSAGE
+	 * as spidev accepts, usually a single one */
+	for (i = 0; i < nb_accesses; i++) {
+		for (position = 0; position < accesses[i].count; position += data_size) {
+			data_size = (accesses[i].count - position) > chunk_size ? chunk_size : (accesses[i].count - position);
+			if (SPI_Queue(p_platform, accesses[i].reg_address + position,
+					accesses[i].p_data + position, data_size,
+					accesses[i].write_not_read) != 0) {
+				LOG("SPI_Submit: SPI_Queue() failed\n");
+				p_platform->spi_nb_xfers = 0;
+				return VL53L8CX_COMMS_ERROR;
+			}
+		}
+	}
+
+	if (SPI_Flush(p_platform) != 0) {
+		LOG("SPI_Submit: SPI_Flush() failed\n");
+		return VL53L8CX_COMMS_ERROR;
+	}
+
+	return 0;
+}
+
+const VL53L8CX_Transport VL53L8CX_SpiTransport = {
+	.name = "spidev",
+	.open = SPI_Open,
+	.close = SPI_Close,
+	.submit = SPI_Submit,
+	.wait_interrupt = NULL,
+	.get_time_us = NULL,
+	.sleep_until = NULL,
+};
@@ -0,0 +1,172 @@
+/**
+  *
+  * Copyright (c) 2023 STMicroelectronics.
+  * All rights reserved.
+  *
+  * This software is licensed under terms that can be found in the LICENSE file
+  * in the root directory of this software component.
+  * If no LICENSE file comes with this software, it is provided AS-IS.
+  *
+  ******************************************************************************
+  */
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define VL53L8CX_SWAP_X86
+#elif defined(__ARM_NEON) && (__BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__)
+#include <arm_neon.h>
+#define VL53L8CX_SWAP_NEON
+#endif
+
+#include "platform.h"
+
+typedef void (*VL53L8CX_SwapFunction)(uint8_t *buffer, uint16_t size);
+
+static void Swap_Scalar(
+		uint8_t 		*buffer,
+		uint16_t 	 	 size)
+{
+	uint32_t i, tmp;
+
+	/* Example of possible implementation using <string.h> */
+	for(i = 0; i < size; i = i + 4)
+	{
+		tmp = (
+		  buffer[i]<<24)
+		|(buffer[i+1]<<16)
+		|(buffer[i+2]<<8)
+		|(buffer[i+3]);
+
+		memcpy(&(buffer[i]), &tmp, 4);
+	}
+}
+
+#ifdef VL53L8CX_SWAP_X86
+
+__attribute__((target("ssse3")))
+static void Swap_Ssse3(
+		uint8_t 		*buffer,
+		uint16_t 	 	 size)
+{
+	const __m128i mask = _mm_set_epi8(12, 13, 14, 15, 8, 9, 10, 11,
+			4, 5, 6, 7, 0, 1, 2, 3);
+	uint32_t i;
+
+	for (i = 0; i + 16 <= size; i += 16)
+		_mm_storeu_si128((__m128i *)&buffer[i], _mm_shuffle_epi8(
+			_mm_loadu_si128((const __m128i *)&buffer[i]), mask));
+
+	Swap_Scalar(&buffer[i], (uint16_t)(size - i));
+}
+
+__attribute__((target("avx2")))
+static void Swap_Avx2(
+		uint8_t 		*buffer,
+		uint16_t 	 	 size)
+{
+	/* The shuffle works within each 128 bits lane */
+	const __m256i mask = _mm256_set_epi8(12, 13, 14, 15, 8, 9, 10, 11,
+			4, 5, 6, 7, 0, 1, 2, 3, 12, 13, 14, 15, 8, 9, 10, 11,
+			4, 5, 6, 7, 0, 1, 2, 3);
+	uint32_t i;
+
+	for (i = 0; i + 32 <= size; i += 32)
+		_mm256_storeu_si256((__m256i *)&buffer[i], _mm256_shuffle_epi8(
+			_mm256_loadu_si256((const __m256i *)&buffer[i]), mask));
+
+	/* The upper halves are cleared before any code using the SSE encoding
+	 * runs, else each SSE instruction pays a state transition */
+	_mm256_zeroupper();
+	for (; i + 16 <= size; i += 16)
+		_mm_storeu_si128((__m128i *)&buffer[i], _mm_shuffle_epi8(
+			_mm_loadu_si128((const __m128i *)&buffer[i]),
+			_mm256_castsi256_si128(mask)));
+
+	Swap_Scalar(&buffer[i], (uint16_t)(size - i));
+}
+
+#endif
+
+#ifdef VL53L8CX_SWAP_NEON
+
+static void Swap_Neon(
+		uint8_t 		*buffer,
+		uint16_t 	 	 size)
+{
+	uint32_t i;
+
+	for (i = 0; i + 16 <= size; i += 16)
+		vst1q_u8(&buffer[i], vrev32q_u8(vld1q_u8(&buffer[i])));
+
+	Swap_Scalar(&buffer[i], (uint16_t)(size - i));
+}
+
+#endif
+
+/*
+ * Implementations, the fastest first
+ */
+static const struct
+{
+	const char *name;
+	VL53L8CX_SwapFunction swap;
+} swap_functions[] = {
+#ifdef VL53L8CX_SWAP_X86
+	{"avx2", Swap_Avx2},
+	{"ssse3", Swap_Ssse3},
+#endif
+#ifdef VL53L8CX_SWAP_NEON
+	{"neon", Swap_Neon},
+#endif
+	{"scalar", Swap_Scalar},
+};
+
+static int Swap_Supported(VL53L8CX_SwapFunction swap)
+{
+#ifdef VL53L8CX_SWAP_X86
+	__builtin_cpu_init();
+	if (swap == Swap_Avx2)
+		return __builtin_cpu_supports("avx2");
+	if (swap == Swap_Ssse3)
+		return __builtin_cpu_supports("ssse3");
+#endif
+	/* NEON is part of the build target when compiled in */
+	return 1;
+}
+
+static void Swap_Resolve(uint8_t *buffer, uint16_t size);
+
+/* Selected on the first swap */
+static VL53L8CX_SwapFunction swap_function = Swap_Resolve;
+
+static void Swap_Resolve(
+		uint8_t 		*buffer,
+		uint16_t 	 	 size)
+{
+	(void)VL53L8CX_SelectSwapBuffer(NULL);
+	swap_function(buffer, size);
+}
+
+const char *VL53L8CX_SelectSwapBuffer(
+		const char *name)
+{
+	uint32_t i;
+
+	for (i = 0; i < sizeof(swap_functions) / sizeof(swap_functions[0]); i++) {
+		if ((name != NULL) && (strcmp(name, swap_functions[i].name) != 0))
+			continue;
+		if (!Swap_Supported(swap_functions[i].swap))
+			continue;
+		swap_function = swap_functions[i].swap;
+		return swap_functions[i].name;
+	}
+
+	return NULL;
+}
+
+void VL53L8CX_SwapBuffer(
+		uint8_t 		*buffer,
+		uint16_t 	 	 size)
+{
+	swap_function(buffer, size);
+}
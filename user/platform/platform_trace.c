@@ -0,0 +1,550 @@
+/**
+  *
+  * Copyright (c) 2023 STMicroelectronics.
+  * All rights reserved.
+  *
+  * This software is licensed under terms that can be found in the LICENSE file
+  * in the root directory of this software component.
+  * If no LICENSE file comes with this software, it is provided AS-IS.
+  *
+  ******************************************************************************
+  */
+
+#include <errno.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h> // clock_nanosleep()
+
+#include "platform.h"
+
+#define VL53L8CX_COMMS_ERROR		-2
+
+#define LOG 				printf
+
+/*
+ * Trace file: a header (magic, version, 3 reserved bytes, recording start
+ * time in us, little endian), then one record per event. A record starts with
+ * its type and the time elapsed since the previous record (varint, us):
+ * - 'W', 'R': register access, register index (16 bits, little endian), size
+ *   (varint), and the bytes written or read;
+ * - 'I': interrupt wait, result of VL53L8CX_Transport.wait_interrupt (int8);
+ * - 'T': time query, the time returned is the record time;
+ * - 'E': failed submission, in place of its accesses.
+ */
+#define TRACE_MAGIC			"VL8T"
+#define TRACE_VERSION			1
+#define TRACE_HEADER_SIZE		16U
+#define TRACE_RECORD_HEAD_SIZE		(1U + 10U + 2U + 5U)
+#define TRACE_DUMP_BYTES		16U
+
+#define TRACE_WRITE			'W'
+#define TRACE_READ			'R'
+#define TRACE_INTERRUPT			'I'
+#define TRACE_TIME			'T'
+#define TRACE_ERROR			'E'
+
+typedef struct
+{
+	uint8_t type;
+	uint64_t delta_us;
+	uint16_t reg_address;
+	uint32_t count;
+	const uint8_t *p_data;
+	int8_t result;
+	uint32_t next;
+} VL53L8CX_TraceRecord;
+
+typedef struct
+{
+	const VL53L8CX_Transport *transport;
+	FILE *file;
+	uint64_t time_us;
+	uint8_t write_failed;
+} VL53L8CX_Recorder;
+
+typedef struct
+{
+	uint8_t *trace;
+	uint32_t size;
+	uint32_t pos;
+	uint32_t record;
+	uint64_t start_us;
+	uint64_t time_us;
+	uint64_t wall_us;
+	uint8_t diverged;
+} VL53L8CX_Replay;
+
+static void Trace_SleepUntil(uint64_t time_us)
+{
+	struct timespec ts;
+
+	ts.tv_sec = time_us / 1000000;
+	ts.tv_nsec = (time_us % 1000000) * 1000;
+	while (clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &ts, NULL) == EINTR)
+		;
+}
+
+static uint32_t Trace_PutVarint(uint8_t *buffer, uint64_t value)
+{
+	uint32_t size = 0;
+
+	while (value >= 0x80) {
+		buffer[size++] = (uint8_t)(value | 0x80);
+		value >>= 7;
+	}
+	buffer[size++] = (uint8_t)value;
+	return size;
+}
+
+static int32_t Trace_GetVarint(const uint8_t *trace, uint32_t size, uint32_t *p_pos, uint64_t *p_value)
+{
+	uint32_t shift = 0;
+	uint64_t value = 0;
+
+	do {
+		if ((*p_pos >= size) || (shift > 63))
+			return -1;
+		value |= (uint64_t)(trace[*p_pos] & 0x7F) << shift;
+		shift += 7;
+	} while (trace[(*p_pos)++] & 0x80);
+
+	*p_value = value;
+	return 0;
+}
+
+/*
+ * Parse the record at 'pos'. Returns 0 if OK, -1 at the end of the trace or on
+ * a truncated record.
+ */
+static int32_t Trace_Parse(const uint8_t *trace, uint32_t size, uint32_t pos, VL53L8CX_TraceRecord *p_record)
+{
+	uint64_t value;
+
+	if (pos >= size)
+		return -1;
+
+	memset(p_record, 0, sizeof(*p_record));
+	p_record->type = trace[pos++];
+	if (Trace_GetVarint(trace, size, &pos, &p_record->delta_us) != 0)
+		return -1;
+
+	switch (p_record->type) {
+	case TRACE_WRITE:
+	case TRACE_READ:
+		if (pos + 2 > size)
+			return -1;
+		p_record->reg_address = (uint16_t)(trace[pos] | (trace[pos + 1] << 8));
+		pos += 2;
+		if ((Trace_GetVarint(trace, size, &pos, &value) != 0) || (value > size - pos))
+			return -1;
+		p_record->count = (uint32_t)value;
+		p_record->p_data = &trace[pos];
+		pos += p_record->count;
+		break;
+	case TRACE_INTERRUPT:
+		if (pos + 1 > size)
+			return -1;
+		p_record->result = (int8_t)trace[pos++];
+		break;
+	case TRACE_TIME:
+	case TRACE_ERROR:
+		break;
+	default:
+		return -1;
+	}
+
+	p_record->next = pos;
+	return 0;
+}
+
+/*
+ * Load a whole trace file and check its header. Returns the trace, NULL on
+ * error.
+ */
+static uint8_t *Trace_Load(const char *trace_file, uint32_t *p_size, uint64_t *p_start_us)
+{
+	uint8_t *trace = NULL;
+	FILE *file;
+	long size;
+	uint32_t i;
+
+	file = fopen(trace_file, "rb");
+	if (file == NULL) {
+		LOG("Failed to open %s\n", trace_file);
+		return NULL;
+	}
+
+	if ((fseek(file, 0, SEEK_END) == 0) && ((size = ftell(file)) >= (long)TRACE_HEADER_SIZE)
+		&& (fseek(file, 0, SEEK_SET) == 0)) {
+		trace = malloc((size_t)size);
+		if ((trace != NULL) && (fread(trace, 1, (size_t)size, file) != (size_t)size)) {
+			free(trace);
+			trace = NULL;
+		}
+	}
+	fclose(file);
+
+	if ((trace == NULL) || (memcmp(trace, TRACE_MAGIC, 4) != 0) || (trace[4] != TRACE_VERSION)) {
+		LOG("%s is not a bus trace\n", trace_file);
+		free(trace);
+		return NULL;
+	}
+
+	*p_start_us = 0;
+	for (i = 0; i < 8; i++)
+		*p_start_us |= (uint64_t)trace[8 + i] << (8 * i);
+	*p_size = (uint32_t)size;
+	return trace;
+}
+
+static void Recorder_Put(VL53L8CX_Recorder *recorder, uint8_t type, uint64_t time_us,
+		uint16_t reg_address, const uint8_t *p_data, uint32_t count, int8_t result)
+{
+	uint8_t head[TRACE_RECORD_HEAD_SIZE];
+	uint32_t size = 0;
+
+	head[size++] = type;
+	size += Trace_PutVarint(&head[size], time_us - recorder->time_us);
+	recorder->time_us = time_us;
+
+	if ((type == TRACE_WRITE) || (type == TRACE_READ)) {
+		head[size++] = (uint8_t)reg_address;
+		head[size++] = (uint8_t)(reg_address >> 8);
+		size += Trace_PutVarint(&head[size], count);
+	}
+	else if (type == TRACE_INTERRUPT) {
+		head[size++] = (uint8_t)result;
+	}
+
+	if ((fwrite(head, 1, size, recorder->file) != size)
+		|| ((count != 0) && (fwrite(p_data, 1, count, recorder->file) != count))) {
+		if (!recorder->write_failed)
+			LOG("Recorder: failed to write the trace\n");
+		recorder->write_failed = 1;
+	}
+}
+
+static void Recorder_Close(VL53L8CX_Platform *p_platform)
+{
+	VL53L8CX_Recorder *recorder = (VL53L8CX_Recorder *)p_platform->trace_data;
+
+	recorder->transport->close(p_platform);
+	fclose(recorder->file);
+	free(recorder);
+	p_platform->trace_data = NULL;
+}
+
+static int32_t Recorder_Open(VL53L8CX_Platform *p_platform)
+{
+	VL53L8CX_Recorder *recorder;
+	uint8_t header[TRACE_HEADER_SIZE] = {0};
+	uint32_t i;
+
+	if ((p_platform->trace_transport == &VL53L8CX_RecorderTransport)
+		|| (p_platform->trace_transport == &VL53L8CX_ReplayTransport)) {
+		LOG("Recorder: cannot record a trace transport\n");
+		return VL53L8CX_COMMS_ERROR;
+	}
+
+	recorder = calloc(1, sizeof(VL53L8CX_Recorder));
+	if (recorder == NULL)
+		return VL53L8CX_COMMS_ERROR;
+	recorder->transport = (p_platform->trace_transport != NULL)
+		? p_platform->trace_transport : VL53L8CX_DEFAULT_TRANSPORT;
+
+	recorder->file = fopen(p_platform->trace_file, "wb");
+	if (recorder->file == NULL) {
+		LOG("Failed to create %s\n", p_platform->trace_file);
+		free(recorder);
+		return VL53L8CX_COMMS_ERROR;
+	}
+
+	recorder->time_us = VL53L8CX_ClockTimeUs();
+	memcpy(header, TRACE_MAGIC, 4);
+	header[4] = TRACE_VERSION;
+	for (i = 0; i < 8; i++)
+		header[8 + i] = (uint8_t)(recorder->time_us >> (8 * i));
+	if (fwrite(header, 1, sizeof(header), recorder->file) != sizeof(header)) {
+		LOG("Failed to write %s\n", p_platform->trace_file);
+		fclose(recorder->file);
+		free(recorder);
+		return VL53L8CX_COMMS_ERROR;
+	}
+
+	if (recorder->transport->open(p_platform) != 0) {
+		fclose(recorder->file);
+		free(recorder);
+		return VL53L8CX_COMMS_ERROR;
+	}
+	p_platform->trace_data = recorder;
+
+	return 0;
+}
+
+static int32_t Recorder_Submit(VL53L8CX_Platform *p_platform, VL53L8CX_Access *accesses, uint16_t nb_accesses)
+{
+	VL53L8CX_Recorder *recorder = (VL53L8CX_Recorder *)p_platform->trace_data;
+	uint64_t now;
+	uint16_t i;
+	int32_t status;
+
+	status = recorder->transport->submit(p_platform, accesses, nb_accesses);
+	now = VL53L8CX_ClockTimeUs();
+
+	if (status != 0) {
+		Recorder_Put(recorder, TRACE_ERROR, now, 0, NULL, 0, 0);
+		return status;
+	}
+
+	for (i = 0; i < nb_accesses; i++)
+		Recorder_Put(recorder, accesses[i].write_not_read ? TRACE_WRITE : TRACE_READ,
+			now, accesses[i].reg_address, accesses[i].p_data, accesses[i].count, 0);
+
+	return 0;
+}
+
+static int32_t Recorder_WaitInterrupt(VL53L8CX_Platform *p_platform, uint64_t deadline_us)
+{
+	VL53L8CX_Recorder *recorder = (VL53L8CX_Recorder *)p_platform->trace_data;
+	int32_t ret;
+
+	/* Same path as the recorded transport: poll if it has no interrupt */
+	if (recorder->transport->wait_interrupt == NULL)
+		return -2;
+
+	ret = recorder->transport->wait_interrupt(p_platform, deadline_us);
+	Recorder_Put(recorder, TRACE_INTERRUPT, VL53L8CX_ClockTimeUs(), 0, NULL, 0, (int8_t)ret);
+
+	return ret;
+}
+
+static uint64_t Recorder_GetTimeUs(VL53L8CX_Platform *p_platform)
+{
+	VL53L8CX_Recorder *recorder = (VL53L8CX_Recorder *)p_platform->trace_data;
+	uint64_t now = VL53L8CX_ClockTimeUs();
+
+	Recorder_Put(recorder, TRACE_TIME, now, 0, NULL, 0, 0);
+	return now;
+}
+
+static void Recorder_SleepUntil(VL53L8CX_Platform *p_platform, uint64_t time_us)
+{
+	Trace_SleepUntil(time_us);
+}
+
+/*
+ * Stop following the trace. The replay then behaves as a sensor which does
+ * not answer, with the time running so that the waits of the ULD end.
+ */
+static void Replay_Diverge(VL53L8CX_Replay *replay, const char *reason)
+{
+	if (!replay->diverged)
+		LOG("Replay: the ULD left the trace at record %u: %s\n", replay->record, reason);
+	replay->diverged = 1;
+	replay->wall_us = VL53L8CX_ClockTimeUs();
+}
+
+/*
+ * Move past a record, at the recorded pace in real time mode
+ */
+static void Replay_Consume(VL53L8CX_Platform *p_platform, VL53L8CX_Replay *replay,
+		VL53L8CX_TraceRecord *p_record)
+{
+	replay->pos = p_record->next;
+	replay->time_us += p_record->delta_us;
+	replay->record++;
+
+	if (p_platform->trace_realtime)
+		Trace_SleepUntil(replay->wall_us + (replay->time_us - replay->start_us));
+}
+
+static void Replay_Close(VL53L8CX_Platform *p_platform)
+{
+	VL53L8CX_Replay *replay = (VL53L8CX_Replay *)p_platform->trace_data;
+
+	free(replay->trace);
+	free(replay);
+	p_platform->trace_data = NULL;
+}
+
+static int32_t Replay_Open(VL53L8CX_Platform *p_platform)
+{
+	VL53L8CX_Replay *replay;
+
+	p_platform->fd = -1;
+	replay = calloc(1, sizeof(VL53L8CX_Replay));
+	if (replay == NULL)
+		return VL53L8CX_COMMS_ERROR;
+
+	replay->trace = Trace_Load(p_platform->trace_file, &replay->size, &replay->start_us);
+	if (replay->trace == NULL) {
+		free(replay);
+		return VL53L8CX_COMMS_ERROR;
+	}
+	replay->pos = TRACE_HEADER_SIZE;
+	replay->time_us = replay->start_us;
+	replay->wall_us = VL53L8CX_ClockTimeUs();
+	p_platform->trace_data = replay;
+
+	return 0;
+}
+
+static int32_t Replay_Submit(VL53L8CX_Platform *p_platform, VL53L8CX_Access *accesses, uint16_t nb_accesses)
+{
+	VL53L8CX_Replay *replay = (VL53L8CX_Replay *)p_platform->trace_data;
+	VL53L8CX_TraceRecord record;
+	uint8_t type;
+	uint16_t i;
+
+	for (i = 0; i < nb_accesses; i++) {
+		if (replay->diverged)
+			return VL53L8CX_COMMS_ERROR;
+
+		if (Trace_Parse(replay->trace, replay->size, replay->pos, &record) != 0) {
+			Replay_Diverge(replay, "end of trace");
+			return VL53L8CX_COMMS_ERROR;
+		}
+
+		if ((record.type == TRACE_ERROR) && (i == 0)) {
+			Replay_Consume(p_platform, replay, &record);
+			return VL53L8CX_COMMS_ERROR;
+		}
+
+		type = accesses[i].write_not_read ? TRACE_WRITE : TRACE_READ;
+		if ((record.type != type) || (record.reg_address != accesses[i].reg_address)
+			|| (record.count != accesses[i].count)) {
+			Replay_Diverge(replay, "other register access");
+			return VL53L8CX_COMMS_ERROR;
+		}
+
+		if (type == TRACE_WRITE) {
+			if (memcmp(record.p_data, accesses[i].p_data, record.count) != 0) {
+				Replay_Diverge(replay, "other data written");
+				return VL53L8CX_COMMS_ERROR;
+			}
+		}
+		else
+			memcpy(accesses[i].p_data, record.p_data, record.count);
+
+		Replay_Consume(p_platform, replay, &record);
+	}
+
+	return 0;
+}
+
+static int32_t Replay_WaitInterrupt(VL53L8CX_Platform *p_platform, uint64_t deadline_us)
+{
+	VL53L8CX_Replay *replay = (VL53L8CX_Replay *)p_platform->trace_data;
+	VL53L8CX_TraceRecord record;
+
+	if (replay->diverged)
+		return -1;
+
+	/* Recorded without interrupt: poll */
+	if ((Trace_Parse(replay->trace, replay->size, replay->pos, &record) != 0)
+		|| (record.type != TRACE_INTERRUPT))
+		return -2;
+
+	Replay_Consume(p_platform, replay, &record);
+	return record.result;
+}
+
+static uint64_t Replay_GetTimeUs(VL53L8CX_Platform *p_platform)
+{
+	VL53L8CX_Replay *replay = (VL53L8CX_Replay *)p_platform->trace_data;
+	VL53L8CX_TraceRecord record;
+
+	if (!replay->diverged) {
+		if ((Trace_Parse(replay->trace, replay->size, replay->pos, &record) == 0)
+			&& (record.type == TRACE_TIME)) {
+			Replay_Consume(p_platform, replay, &record);
+			return replay->time_us;
+		}
+		Replay_Diverge(replay, "other time query");
+	}
+
+	return replay->time_us + (VL53L8CX_ClockTimeUs() - replay->wall_us);
+}
+
+static void Replay_SleepUntil(VL53L8CX_Platform *p_platform, uint64_t time_us)
+{
+	VL53L8CX_Replay *replay = (VL53L8CX_Replay *)p_platform->trace_data;
+
+	uint64_t now;
+
+	/* The pace is given by the records, and the waits of a diverged replay
+	 * are skipped */
+	if (replay->diverged) {
+		now = Replay_GetTimeUs(p_platform);
+		if (time_us > now)
+			replay->time_us += time_us - now;
+	}
+}
+
+int32_t VL53L8CX_TraceDump(
+		const char *trace_file,
+		uint8_t with_time)
+{
+	VL53L8CX_TraceRecord record;
+	uint8_t *trace;
+	uint32_t size, pos = TRACE_HEADER_SIZE, i, hash;
+	uint64_t start_us, time_us = 0;
+
+	trace = Trace_Load(trace_file, &size, &start_us);
+	if (trace == NULL)
+		return VL53L8CX_COMMS_ERROR;
+
+	while (Trace_Parse(trace, size, pos, &record) == 0) {
+		pos = record.next;
+		time_us += record.delta_us;
+		if ((record.type == TRACE_TIME) && !with_time)
+			continue;
+
+		if (with_time)
+			printf("%12llu ", (unsigned long long)time_us);
+		printf("%c", record.type);
+
+		if ((record.type == TRACE_WRITE) || (record.type == TRACE_READ)) {
+			printf(" 0x%04x %5u :", record.reg_address, record.count);
+			for (i = 0; (i < record.count) && (i < TRACE_DUMP_BYTES); i++)
+				printf(" %02x", record.p_data[i]);
+			if (record.count > TRACE_DUMP_BYTES) {
+				/* FNV-1a of the whole payload */
+				hash = 2166136261U;
+				for (i = 0; i < record.count; i++)
+					hash = (hash ^ record.p_data[i]) * 16777619U;
+				printf(" ... %08x", hash);
+			}
+		}
+		else if (record.type == TRACE_INTERRUPT) {
+			printf(" %d", record.result);
+		}
+		printf("\n");
+	}
+
+	if (pos != size)
+		LOG("%s: truncated record at byte %u\n", trace_file, pos);
+	free(trace);
+
+	return (pos == size) ? 0 : VL53L8CX_COMMS_ERROR;
+}
+
+const VL53L8CX_Transport VL53L8CX_RecorderTransport = {
+	.name = "recorder",
+	.open = Recorder_Open,
+	.close = Recorder_Close,
+	.submit = Recorder_Submit,
+	.wait_interrupt = Recorder_WaitInterrupt,
+	.get_time_us = Recorder_GetTimeUs,
+	.sleep_until = Recorder_SleepUntil,
+};
+
+const VL53L8CX_Transport VL53L8CX_ReplayTransport = {
+	.name = "replay",
+	.open = Replay_Open,
+	.close = Replay_Close,
+	.submit = Replay_Submit,
+	.wait_interrupt = Replay_WaitInterrupt,
+	.get_time_us = Replay_GetTimeUs,
+	.sleep_until = Replay_SleepUntil,
+};
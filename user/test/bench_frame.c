@@ -0,0 +1,267 @@
+/**
+  *
+  * Copyright (c) 2023 STMicroelectronics.
+  * All rights reserved.
+  *
+  * This software is licensed under terms that can be found in the LICENSE file
+  * in the root directory of this software component.
+  * If no LICENSE file comes with this software, it is provided AS-IS.
+  *
+  ******************************************************************************
+  */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "vl53l8cx_api.h"
+
+/* Benchmark of the frame decoding of vl53l8cx_get_ranging_data():
+ * ./bench_frame [iterations]. Frames are recorded from the emulated sensor
+ * (noisy scene with empty zones), then played back in a loop from memory by
+ * the transport of the benchmarked device. The time of the frame read alone
+ * is measured first, and taken out of the decoding time. The frames carry
+ * the results CRC: its check is the median difference of decoding runs with
+ * and without it, run back to back so that both see the same CPU state. The
+ * results view (vl53l8cx_get_ranging_view()) is timed reading the distance
+ * and the target status only, without CRC. The last configuration only
+ * enables the outputs needed for the distance (vl53l8cx_set_outputs()).
+ * bench_frame_scalar is the same benchmark with VL53L8CX_DISABLE_SIMD. */
+
+#define BENCH_RUNS		5
+#define BENCH_CRC_PAIRS		15
+#define BENCH_NB_FRAMES		32
+
+/* What bench_run() times */
+#define BENCH_READ		0
+#define BENCH_DECODE		1
+#define BENCH_VIEW		2
+
+/* Benchmarked configurations */
+static const struct {
+	const char *name;
+	uint8_t resolution;
+	uint16_t outputs;
+} configs[] = {
+	{"4x4", VL53L8CX_RESOLUTION_4X4, VL53L8CX_OUTPUTS_AVAILABLE},
+	{"8x8", VL53L8CX_RESOLUTION_8X8, VL53L8CX_OUTPUTS_AVAILABLE},
+	{"8x8-d", VL53L8CX_RESOLUTION_8X8, VL53L8CX_OUTPUT_NB_TARGET_DETECTED
+		| VL53L8CX_OUTPUT_DISTANCE_MM | VL53L8CX_OUTPUT_TARGET_STATUS},
+};
+
+/* Recorded frames, as read on the bus */
+typedef struct {
+	uint8_t frames[BENCH_NB_FRAMES][VL53L8CX_TEMPORARY_BUFFER_SIZE];
+	uint32_t size;
+	uint32_t next;
+} BenchFrames;
+
+static BenchFrames recorded;
+
+static int32_t Frames_Open(VL53L8CX_Platform *p_platform)
+{
+	p_platform->fd = -1;
+	return 0;
+}
+
+static void Frames_Close(VL53L8CX_Platform *p_platform)
+{
+}
+
+/* Reads of the results get the next recorded frame, other accesses are
+ * dropped */
+static int32_t Frames_Submit(VL53L8CX_Platform *p_platform,
+		VL53L8CX_Access *accesses, uint16_t nb_accesses)
+{
+	BenchFrames *p_frames = (BenchFrames *)p_platform->transport_data;
+	uint16_t i;
+
+	for (i = 0; i < nb_accesses; i++) {
+		if (accesses[i].write_not_read)
+			continue;
+		if ((accesses[i].reg_address == 0)
+			&& (accesses[i].count == p_frames->size)) {
+			memcpy(accesses[i].p_data,
+				p_frames->frames[p_frames->next], p_frames->size);
+			p_frames->next = (p_frames->next + 1) % BENCH_NB_FRAMES;
+		}
+		else
+			memset(accesses[i].p_data, 0, accesses[i].count);
+	}
+
+	return 0;
+}
+
+static const VL53L8CX_Transport FramesTransport = {
+	.name = "recorded frames",
+	.open = Frames_Open,
+	.close = Frames_Close,
+	.submit = Frames_Submit,
+};
+
+/* Time of one run, in ns per iteration */
+static double bench_pass(VL53L8CX_Configuration *p_dev,
+		VL53L8CX_ResultsData *p_results, uint32_t iterations,
+		uint8_t mode)
+{
+	uint64_t start_us;
+	uint32_t i;
+
+	start_us = VL53L8CX_GetTimeUs(NULL);
+	for (i = 0; i < iterations; i++) {
+		if (mode == BENCH_DECODE)
+			(void)vl53l8cx_get_ranging_data(p_dev, p_results);
+		else if (mode == BENCH_VIEW) {
+			(void)vl53l8cx_get_ranging_view(p_dev);
+			(void)vl53l8cx_view_distance_mm(p_dev);
+			(void)vl53l8cx_view_target_status(p_dev);
+		}
+		else
+			(void)VL53L8CX_RdMulti(&p_dev->platform, 0x0,
+				p_dev->temp_buffer, p_dev->data_read_size);
+	}
+
+	return (double)(VL53L8CX_GetTimeUs(NULL) - start_us) * 1000.0
+		/ iterations;
+}
+
+/* Best time of BENCH_RUNS runs, in ns per iteration */
+static double bench_run(VL53L8CX_Configuration *p_dev,
+		VL53L8CX_ResultsData *p_results, uint32_t iterations,
+		uint8_t mode)
+{
+	double ns, best_ns = 0;
+	uint32_t run;
+
+	for (run = 0; run < BENCH_RUNS; run++) {
+		ns = bench_pass(p_dev, p_results, iterations, mode);
+		if ((run == 0) || (ns < best_ns))
+			best_ns = ns;
+	}
+
+	return best_ns;
+}
+
+static int bench_compare(const void *a, const void *b)
+{
+	double x = *(const double *)a, y = *(const double *)b;
+
+	return (x > y) - (x < y);
+}
+
+/* CRC check of the decoding, in ns per frame: median over BENCH_CRC_PAIRS
+ * of the difference between a decoding run with the CRC and one without,
+ * in alternate order */
+static double bench_crc(VL53L8CX_Configuration *p_dev,
+		VL53L8CX_ResultsData *p_results, uint32_t iterations)
+{
+	double diffs[BENCH_CRC_PAIRS], ns[2];
+	uint32_t pair, k;
+	uint8_t crc;
+
+	for (pair = 0; pair < BENCH_CRC_PAIRS; pair++) {
+		for (k = 0; k < 2; k++) {
+			crc = (uint8_t)((pair + k) % 2);
+			p_dev->crc_checksum_for_results_pkt = crc;
+			ns[crc] = bench_pass(p_dev, p_results, iterations,
+				BENCH_DECODE);
+		}
+		diffs[pair] = ns[1] - ns[0];
+	}
+
+	qsort(diffs, BENCH_CRC_PAIRS, sizeof(diffs[0]), bench_compare);
+	return diffs[BENCH_CRC_PAIRS / 2];
+}
+
+int main(int argc, char ** argv)
+{
+	static VL53L8CX_Configuration Dev, Bench;
+	static VL53L8CX_ResultsData Results;
+	VL53L8CX_Platform platform;
+	VL53L8CX_EmulatorScene scene;
+	uint32_t iterations = 100000, i, j;
+	double read_ns, decode_ns, crc_ns, view_ns;
+	uint8_t status;
+
+	if (argc >= 2)
+		iterations = (uint32_t)atoi(argv[1]);
+
+	memset(&Dev, 0, sizeof(Dev));
+	Dev.platform.transport = &VL53L8CX_EmulatorTransport;
+	if (vl53l8cx_comms_init(&Dev.platform) || vl53l8cx_init(&Dev)) {
+		printf("VL53L8CX emulator init failed\n");
+		return -1;
+	}
+
+	memset(&scene, 0, sizeof(scene));
+	for (i = 0; i < VL53L8CX_EMULATOR_NB_ZONES; i++) {
+		scene.distance_mm[i] = (i % 7 == 0) ? 0 : (uint16_t)(300 + 40 * i);
+		scene.reflectance_percent[i] = (uint8_t)(10 + i);
+	}
+	scene.ambient_kcps_per_spad = 5;
+	scene.silicon_temp_degc = 35;
+	scene.noise_mm = 20;
+	scene.seed = 1;
+	(void)VL53L8CX_EmulatorSetScene(&Dev.platform, &scene);
+	if (vl53l8cx_set_results_crc(&Dev, 1)) {
+		printf("VL53L8CX emulator CRC setting failed\n");
+		return -1;
+	}
+
+	memset(&Bench, 0, sizeof(Bench));
+	Bench.platform.transport = &FramesTransport;
+	Bench.platform.transport_data = &recorded;
+	if (vl53l8cx_comms_init(&Bench.platform)) {
+		printf("VL53L8CX recorded frames init failed\n");
+		return -1;
+	}
+
+	printf("%-6s %6s %10s %10s %10s %10s\n", "config", "bytes", "read ns",
+		"decode ns", "crc ns", "view ns");
+	for (i = 0; i < sizeof(configs) / sizeof(configs[0]); i++) {
+		status = vl53l8cx_set_resolution(&Dev, configs[i].resolution);
+		status |= vl53l8cx_set_outputs(&Dev, configs[i].outputs);
+		status |= vl53l8cx_set_ranging_frequency_hz(&Dev, 60);
+		status |= vl53l8cx_start_ranging(&Dev);
+
+		recorded.size = Dev.data_read_size;
+		recorded.next = 0;
+		for (j = 0; (status == 0) && (j < BENCH_NB_FRAMES); j++) {
+			if (!VL53L8CX_wait_for_dataready(&Dev.platform))
+				status = 1;
+			status |= VL53L8CX_RdMulti(&Dev.platform, 0x0,
+				recorded.frames[j], recorded.size);
+		}
+		status |= vl53l8cx_stop_ranging(&Dev);
+		if (status) {
+			printf("VL53L8CX emulator ranging failed\n");
+			return -1;
+		}
+
+		/* Same configuration and frame layout, on the recorded frames */
+		platform = Bench.platform;
+		Bench = Dev;
+		Bench.platform = platform;
+
+		for (j = 0; j < BENCH_NB_FRAMES; j++) {
+			if (vl53l8cx_get_ranging_data(&Bench, &Results)) {
+				printf("VL53L8CX recorded frame %u rejected\n", j);
+				return -1;
+			}
+		}
+
+		read_ns = bench_run(&Bench, &Results, iterations, BENCH_READ);
+		Bench.crc_checksum_for_results_pkt = 0;
+		decode_ns = bench_run(&Bench, &Results, iterations, BENCH_DECODE);
+		view_ns = bench_run(&Bench, &Results, iterations, BENCH_VIEW);
+		crc_ns = bench_crc(&Bench, &Results, iterations);
+		printf("%-6s %6u %10.0f %10.0f %10.0f %10.0f\n",
+			configs[i].name,
+			Bench.data_read_size, read_ns, decode_ns - read_ns,
+			crc_ns, view_ns - read_ns);
+	}
+
+	vl53l8cx_comms_close(&Bench.platform);
+	vl53l8cx_comms_close(&Dev.platform);
+	return 0;
+}
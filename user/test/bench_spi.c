@@ -0,0 +1,298 @@
+/**
+  *
+  * Copyright (c) 2023 STMicroelectronics.
+  * All rights reserved.
+  *
+  * This software is licensed under terms that can be found in the LICENSE file
+  * in the root directory of this software component.
+  * If no LICENSE file comes with this software, it is provided AS-IS.
+  *
+  ******************************************************************************
+  */
+
+#include <fcntl.h>
+#include <unistd.h>
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <linux/spi/spidev.h>
+#include <sys/ioctl.h>
+
+#include "vl53l8cx_api.h"
+
+/* Benchmark of the spidev transport: ./bench_spi [iterations]. No SPI bus is
+ * needed: ioctl() and malloc() are wrapped at link time (see the Makefile).
+ * The spidev ioctls, sent to /dev/null, are counted and served like spidev
+ * does: bufsiz check, copy of the tx data into a kernel buffer and of the rx
+ * data out of it, and one real system call. The spidev transport is compared
+ * with the per-chunk code it replaced ("baseline"): one SPI_IOC_MESSAGE(1) per
+ * 4094 bytes chunk, through tx/rx buffers allocated for each chunk. The
+ * firmware download writes the 3 pages of the firmware (84 KiB) as the ULD,
+ * with the default spidev bufsiz and with spidev.bufsiz=65536. */
+
+#define BENCH_RUNS		5
+#define BENCH_DEVICE		"/dev/null"
+#define BENCH_SPIDEV_BUFSIZ	4096
+#define BENCH_BASELINE_CHUNK	(4096 - 2)
+#define BENCH_MAX_SIZE		VL53L8CX_TEMPORARY_BUFFER_SIZE
+#define BENCH_FIRMWARE_SIZE	0x15000
+
+int __real_ioctl(int fd, unsigned long request, ...);
+void *__real_malloc(size_t size);
+
+/* Counters of the wrapped functions */
+static struct {
+	uint32_t bufsiz;
+	uint64_t ioctls;
+	uint64_t xfers;
+	uint64_t mallocs;
+	uint64_t bus_bytes;
+} mock = {BENCH_SPIDEV_BUFSIZ, 0, 0, 0, 0};
+
+static uint8_t kernel_tx[65536], kernel_rx[65536];
+
+void *__wrap_malloc(size_t size)
+{
+	mock.mallocs++;
+	return __real_malloc(size);
+}
+
+/* spidev: the benchmark has no other SPI device */
+int __wrap_ioctl(int fd, unsigned long request, ...)
+{
+	struct spi_ioc_transfer *xfers;
+	uint32_t i, n, tx_total = 0, rx_total = 0;
+	va_list args;
+	void *arg;
+
+	va_start(args, request);
+	arg = va_arg(args, void *);
+	va_end(args);
+
+	if (_IOC_TYPE(request) != SPI_IOC_MAGIC)
+		return __real_ioctl(fd, request, arg);
+
+	/* Mode, bits and speed settings */
+	if (_IOC_NR(request) != 0)
+		return 0;
+
+	/* The system call itself: /dev/null does not know it */
+	(void)__real_ioctl(fd, request, arg);
+	mock.ioctls++;
+
+	xfers = (struct spi_ioc_transfer *)arg;
+	n = _IOC_SIZE(request) / sizeof(struct spi_ioc_transfer);
+	mock.xfers += n;
+	for (i = 0; i < n; i++) {
+		if (xfers[i].tx_buf)
+			tx_total += (xfers[i].len + 127) & ~127U;
+		if (xfers[i].rx_buf)
+			rx_total += (xfers[i].len + 127) & ~127U;
+	}
+	if ((tx_total > mock.bufsiz) || (rx_total > mock.bufsiz))
+		return -1;
+
+	tx_total = 0;
+	rx_total = 0;
+	for (i = 0; i < n; i++) {
+		if (xfers[i].tx_buf) {
+			memcpy(&kernel_tx[tx_total],
+				(void *)(uintptr_t)xfers[i].tx_buf, xfers[i].len);
+			tx_total += xfers[i].len;
+		}
+		if (xfers[i].rx_buf) {
+			memset(&kernel_rx[rx_total], 0, xfers[i].len);
+			memcpy((void *)(uintptr_t)xfers[i].rx_buf,
+				&kernel_rx[rx_total], xfers[i].len);
+			rx_total += xfers[i].len;
+		}
+		mock.bus_bytes += xfers[i].len;
+	}
+
+	return (int)n;
+}
+
+static int32_t Baseline_Open(VL53L8CX_Platform *p_platform)
+{
+	p_platform->fd = open(BENCH_DEVICE, O_RDWR);
+	return (p_platform->fd == -1) ? -1 : 0;
+}
+
+static void Baseline_Close(VL53L8CX_Platform *p_platform)
+{
+	close(p_platform->fd);
+}
+
+/* Per-chunk transfer of the baseline: index and data in one transfer,
+ * through buffers allocated for the chunk */
+static int32_t Baseline_Xfer(VL53L8CX_Platform *p_platform, uint16_t index,
+		uint8_t *data, uint32_t size, uint8_t write_not_read)
+{
+	struct spi_ioc_transfer message;
+	uint8_t *read_buffer = malloc(size + 2);
+	uint8_t *write_buffer = malloc(size + 2);
+	int32_t error;
+
+	if (write_not_read) {
+		write_buffer[0] = (uint8_t)(((index & 0xFF00) >> 8) | 0x80);
+		memcpy(write_buffer + 2, data, size);
+	}
+	else
+		write_buffer[0] = (uint8_t)((index & 0x7F00) >> 8);
+	write_buffer[1] = (uint8_t)(index & 0xFF);
+
+	memset(&message, 0, sizeof(message));
+	message.tx_buf = (unsigned long)write_buffer;
+	message.rx_buf = (unsigned long)read_buffer;
+	message.len = size + 2;
+	error = ioctl(p_platform->fd, SPI_IOC_MESSAGE(1), &message);
+	if ((error >= 0) && !write_not_read)
+		memcpy(data, read_buffer + 2, size);
+
+	free(read_buffer);
+	free(write_buffer);
+	return (error < 0) ? -1 : 0;
+}
+
+static int32_t Baseline_Submit(VL53L8CX_Platform *p_platform,
+		VL53L8CX_Access *accesses, uint16_t nb_accesses)
+{
+	uint32_t position, size;
+	uint16_t i;
+
+	for (i = 0; i < nb_accesses; i++) {
+		for (position = 0; position < accesses[i].count; position += size) {
+			size = accesses[i].count - position;
+			if (size > BENCH_BASELINE_CHUNK)
+				size = BENCH_BASELINE_CHUNK;
+			if (Baseline_Xfer(p_platform,
+					accesses[i].reg_address + position,
+					accesses[i].p_data + position, size,
+					accesses[i].write_not_read) != 0)
+				return -1;
+		}
+	}
+
+	return 0;
+}
+
+static const VL53L8CX_Transport BaselineTransport = {
+	.name = "baseline",
+	.open = Baseline_Open,
+	.close = Baseline_Close,
+	.submit = Baseline_Submit,
+};
+
+/* Benchmarked register accesses */
+#define BENCH_POLL		0
+#define BENCH_FRAME		1
+#define BENCH_FIRMWARE		2
+
+static const struct {
+	const char *name;
+	uint32_t size;
+} operations[] = {
+	{"poll", 4},
+	{"frame", BENCH_MAX_SIZE},
+	{"fw", BENCH_FIRMWARE_SIZE},
+};
+
+/* Benchmarked transports, with the spidev bufsiz */
+static const struct {
+	const VL53L8CX_Transport *transport;
+	uint32_t bufsiz;
+} configs[] = {
+	{&BaselineTransport, BENCH_SPIDEV_BUFSIZ},
+	{&VL53L8CX_SpiTransport, BENCH_SPIDEV_BUFSIZ},
+	{&VL53L8CX_SpiTransport, 65536},
+};
+
+static uint8_t buffer[BENCH_FIRMWARE_SIZE];
+
+/* One operation, as the ULD does it */
+static uint8_t bench_operation(VL53L8CX_Platform *p_platform, uint8_t operation)
+{
+	static const uint32_t pages[] = {0x8000, 0x8000, 0x5000};
+	uint32_t i, position = 0;
+	uint8_t status = 0;
+
+	if (operation != BENCH_FIRMWARE)
+		return VL53L8CX_RdMulti(p_platform, 0, buffer,
+			operations[operation].size);
+
+	status |= VL53L8CX_BeginTransaction(p_platform);
+	for (i = 0; i < sizeof(pages) / sizeof(pages[0]); i++) {
+		status |= VL53L8CX_WrByte(p_platform, 0x7fff, (uint8_t)(0x09 + i));
+		status |= VL53L8CX_WrMulti(p_platform, 0, &buffer[position],
+			pages[i]);
+		position += pages[i];
+	}
+	status |= VL53L8CX_WrByte(p_platform, 0x7fff, 0x01);
+	status |= VL53L8CX_CommitTransaction(p_platform);
+
+	return status;
+}
+
+int main(int argc, char ** argv)
+{
+	static VL53L8CX_Platform platform;
+	uint32_t iterations = 100000, n, i, j, k, run;
+	uint64_t start_us, elapsed_us, best_us;
+	uint8_t status = 0;
+
+	if (argc >= 2)
+		iterations = (uint32_t)atoi(argv[1]);
+
+	printf("%-9s %6s %-5s %6s %7s %7s %8s %9s %10s\n", "transport",
+		"bufsiz", "op", "bytes", "ioctls", "xfers", "mallocs",
+		"bus bytes", "host ns");
+	for (i = 0; i < sizeof(configs) / sizeof(configs[0]); i++) {
+		memset(&platform, 0, sizeof(platform));
+		platform.transport = configs[i].transport;
+		snprintf(platform.device, sizeof(platform.device), "%s", BENCH_DEVICE);
+		if (vl53l8cx_comms_init(&platform)) {
+			printf("%s init failed\n", configs[i].transport->name);
+			return -1;
+		}
+		mock.bufsiz = configs[i].bufsiz;
+		platform.spi_bufsiz = configs[i].bufsiz;
+
+		for (j = 0; j < sizeof(operations) / sizeof(operations[0]); j++) {
+			/* The firmware download is ~60 times longer */
+			n = (j == BENCH_FIRMWARE) ? (iterations / 64) + 1 : iterations;
+			best_us = 0;
+			for (run = 0; run < BENCH_RUNS; run++) {
+				mock.ioctls = 0;
+				mock.xfers = 0;
+				mock.mallocs = 0;
+				mock.bus_bytes = 0;
+				start_us = VL53L8CX_GetTimeUs(NULL);
+				for (k = 0; k < n; k++)
+					status |= bench_operation(&platform, (uint8_t)j);
+				elapsed_us = VL53L8CX_GetTimeUs(NULL) - start_us;
+				if ((run == 0) || (elapsed_us < best_us))
+					best_us = elapsed_us;
+			}
+			if (status) {
+				printf("%s %s failed\n", configs[i].transport->name,
+					operations[j].name);
+				return -1;
+			}
+
+			printf("%-9s %6u %-5s %6u %7.1f %7.1f %8.1f %9.0f %10.0f\n",
+				configs[i].transport->name, configs[i].bufsiz,
+				operations[j].name, operations[j].size,
+				(double)mock.ioctls / n,
+				(double)mock.xfers / n,
+				(double)mock.mallocs / n,
+				(double)mock.bus_bytes / n,
+				(double)best_us * 1000.0 / n);
+		}
+
+		vl53l8cx_comms_close(&platform);
+	}
+
+	return 0;
+}
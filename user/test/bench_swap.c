@@ -0,0 +1,74 @@
+/**
+  *
+  * Copyright (c) 2023 STMicroelectronics.
+  * All rights reserved.
+  *
+  * This software is licensed under terms that can be found in the LICENSE file
+  * in the root directory of this software component.
+  * If no LICENSE file comes with this software, it is provided AS-IS.
+  *
+  ******************************************************************************
+  */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "vl53l8cx_api.h"
+
+/* Microbenchmark of the VL53L8CX_SwapBuffer() implementations: ./bench_swap
+ * [iterations]. The sizes go from a DCI word to the largest frame. */
+
+#define BENCH_MAX_SIZE		VL53L8CX_TEMPORARY_BUFFER_SIZE
+
+static const char *implementations[] = {"scalar", "ssse3", "avx2", "neon"};
+static const uint16_t sizes[] = {4, 16, 64, 268, 492, BENCH_MAX_SIZE};
+
+int main(int argc, char ** argv)
+{
+	static uint8_t buffer[BENCH_MAX_SIZE], reference[BENCH_MAX_SIZE];
+	uint32_t iterations = 1000000, i, j, k;
+	uint64_t start_us, elapsed_us;
+	const char *name;
+
+	if (argc >= 2)
+		iterations = (uint32_t)atoi(argv[1]);
+
+	for (i = 0; i < BENCH_MAX_SIZE; i++)
+		reference[i] = (uint8_t)(i * 7 + 3);
+
+	printf("%-8s %6s %10s %8s\n", "swap", "bytes", "ns/call", "MB/s");
+	for (i = 0; i < sizeof(implementations) / sizeof(implementations[0]); i++) {
+		name = VL53L8CX_SelectSwapBuffer(implementations[i]);
+		if (name == NULL) {
+			printf("%-8s not supported\n", implementations[i]);
+			continue;
+		}
+
+		/* Check against the byte order before timing */
+		memcpy(buffer, reference, BENCH_MAX_SIZE);
+		VL53L8CX_SwapBuffer(buffer, BENCH_MAX_SIZE - 4);
+		for (k = 0; k < BENCH_MAX_SIZE - 4; k++) {
+			if (buffer[k] != reference[(k & ~3U) + 3 - (k & 3U)]) {
+				printf("%-8s wrong result at byte %u\n", name, k);
+				return -1;
+			}
+		}
+
+		for (j = 0; j < sizeof(sizes) / sizeof(sizes[0]); j++) {
+			start_us = VL53L8CX_GetTimeUs(NULL);
+			for (k = 0; k < iterations; k++)
+				VL53L8CX_SwapBuffer(buffer, sizes[j]);
+			elapsed_us = VL53L8CX_GetTimeUs(NULL) - start_us;
+			if (elapsed_us == 0)
+				elapsed_us = 1;
+
+			printf("%-8s %6u %10.1f %8.0f\n", name, sizes[j],
+				(double)elapsed_us * 1000.0 / iterations,
+				(double)sizes[j] * iterations / elapsed_us);
+		}
+	}
+
+	(void)VL53L8CX_SelectSwapBuffer(NULL);
+	return 0;
+}
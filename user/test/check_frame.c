@@ -0,0 +1,546 @@
+/**
+  *
+  * Copyright (c) 2023 STMicroelectronics.
+  * All rights reserved.
+  *
+  * This software is licensed under terms that can be found in the LICENSE file
+  * in the root directory of this software component.
+  * If no LICENSE file comes with this software, it is provided AS-IS.
+  *
+  ******************************************************************************
+  */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "vl53l8cx_api.h"
+
+/* Differential test of the frame decoding of vl53l8cx_get_ranging_data()
+ * and vl53l8cx_get_ranging_view():
+ * ./check_frame [seed]. Frames are recorded from the emulated sensor (noisy
+ * scene with empty zones and corrupted frames) in 4x4 and 8x8, with and
+ * without the results CRC, for each number of targets per zone and both
+ * results formats. Each frame, and copies of it with random payloads,
+ * corrupted footer or CRC words and unknown blocks, is decoded by the driver
+ * and by the baseline decoder below, from the known block positions and by
+ * walking the block headers, and read again through the results view. The
+ * status and the results of the active zones must be the same. The Makefile
+ * 'check' target runs it with and without SIMD, with
+ * VL53L8CX_FUSED_RESULTS_CRC, with VL53L8CX_USE_RAW_FORMAT and up to 4
+ * targets per zone. */
+
+#define CHECK_NB_FRAMES		10
+#define CHECK_NB_FUZZ		50
+#define CHECK_MAX_BLOCKS	16
+
+/* Frame served to the checked device */
+typedef struct {
+	uint8_t frame[VL53L8CX_TEMPORARY_BUFFER_SIZE];
+	uint32_t size;
+} CheckFrame;
+
+static CheckFrame checked;
+
+static int32_t Frame_Open(VL53L8CX_Platform *p_platform)
+{
+	p_platform->fd = -1;
+	return 0;
+}
+
+static void Frame_Close(VL53L8CX_Platform *p_platform)
+{
+}
+
+/* Reads of the results get the frame, other accesses are dropped */
+static int32_t Frame_Submit(VL53L8CX_Platform *p_platform,
+		VL53L8CX_Access *accesses, uint16_t nb_accesses)
+{
+	CheckFrame *p_frame = (CheckFrame *)p_platform->transport_data;
+	uint16_t i;
+
+	for (i = 0; i < nb_accesses; i++) {
+		if (accesses[i].write_not_read)
+			continue;
+		if ((accesses[i].reg_address == 0)
+			&& (accesses[i].count == p_frame->size))
+			memcpy(accesses[i].p_data, p_frame->frame, p_frame->size);
+		else
+			memset(accesses[i].p_data, 0, accesses[i].count);
+	}
+
+	return 0;
+}
+
+static const VL53L8CX_Transport FrameTransport = {
+	.name = "checked frame",
+	.open = Frame_Open,
+	.close = Frame_Close,
+	.submit = Frame_Submit,
+};
+
+/* Baseline decoder: the frame is swapped to the host byte order, each block
+ * is copied into its results field, then the whole fields are converted. The
+ * blocks of 1 target per zone (_1T) and more (_NT) are both accepted, the
+ * sensor only sends the ones of its number of targets */
+static uint8_t baseline_get_ranging_data(VL53L8CX_Configuration *p_dev,
+		const uint8_t *p_frame, VL53L8CX_ResultsData *p_results)
+{
+	static uint8_t buffer[VL53L8CX_TEMPORARY_BUFFER_SIZE];
+	uint32_t nb = p_dev->nb_target_per_zone, i, j, msize;
+	uint32_t size = p_dev->data_read_size;
+	union Block_header *bh_ptr;
+	uint16_t header_id, footer_id;
+	uint32_t crc_from_packet;
+	uint8_t status = VL53L8CX_STATUS_OK;
+
+	memcpy(buffer, p_frame, size);
+	VL53L8CX_SwapBuffer(buffer, (uint16_t)size);
+
+	/* Start conversion at position 16 to avoid headers */
+	for (i = 16; i < size; i += 4) {
+		bh_ptr = (union Block_header *)&buffer[i];
+		if ((bh_ptr->type > 0x1) && (bh_ptr->type < 0xd))
+			msize = bh_ptr->type * bh_ptr->size;
+		else
+			msize = bh_ptr->size;
+
+		switch (bh_ptr->idx) {
+		case VL53L8CX_METADATA_IDX:
+			p_results->silicon_temp_degc = (int8_t)buffer[i + 12];
+			break;
+#ifndef VL53L8CX_DISABLE_AMBIENT_PER_SPAD
+		case VL53L8CX_AMBIENT_RATE_IDX:
+			memcpy(p_results->ambient_per_spad, &buffer[i + 4], msize);
+			break;
+#endif
+#ifndef VL53L8CX_DISABLE_NB_SPADS_ENABLED
+		case VL53L8CX_SPAD_COUNT_IDX:
+			memcpy(p_results->nb_spads_enabled, &buffer[i + 4], msize);
+			break;
+#endif
+#ifndef VL53L8CX_DISABLE_NB_TARGET_DETECTED
+		case VL53L8CX_NB_TARGET_DETECTED_IDX_1T:
+		case VL53L8CX_NB_TARGET_DETECTED_IDX_NT:
+			memcpy(p_results->nb_target_detected, &buffer[i + 4], msize);
+			break;
+#endif
+#ifndef VL53L8CX_DISABLE_SIGNAL_PER_SPAD
+		case VL53L8CX_SIGNAL_RATE_IDX_1T:
+		case VL53L8CX_SIGNAL_RATE_IDX_NT:
+			memcpy(p_results->signal_per_spad, &buffer[i + 4], msize);
+			break;
+#endif
+#ifndef VL53L8CX_DISABLE_RANGE_SIGMA_MM
+		case VL53L8CX_RANGE_SIGMA_MM_IDX_1T:
+		case VL53L8CX_RANGE_SIGMA_MM_IDX_NT:
+			memcpy(p_results->range_sigma_mm, &buffer[i + 4], msize);
+			break;
+#endif
+#ifndef VL53L8CX_DISABLE_DISTANCE_MM
+		case VL53L8CX_DISTANCE_IDX_1T:
+		case VL53L8CX_DISTANCE_IDX_NT:
+			memcpy(p_results->distance_mm, &buffer[i + 4], msize);
+			break;
+#endif
+#ifndef VL53L8CX_DISABLE_REFLECTANCE_PERCENT
+		case VL53L8CX_REFLECTANCE_EST_PC_IDX_1T:
+		case VL53L8CX_REFLECTANCE_EST_PC_IDX_NT:
+			memcpy(p_results->reflectance, &buffer[i + 4], msize);
+			break;
+#endif
+#ifndef VL53L8CX_DISABLE_TARGET_STATUS
+		case VL53L8CX_TARGET_STATUS_IDX_1T:
+		case VL53L8CX_TARGET_STATUS_IDX_NT:
+			memcpy(p_results->target_status, &buffer[i + 4], msize);
+			break;
+#endif
+#ifndef VL53L8CX_DISABLE_MOTION_INDICATOR
+		case VL53L8CX_MOTION_DETEC_IDX_1T:
+		case VL53L8CX_MOTION_DETEC_IDX_NT:
+			memcpy(&p_results->motion_indicator, &buffer[i + 4], msize);
+			break;
+#endif
+		default:
+			break;
+		}
+		i += msize;
+	}
+
+	if (!p_dev->is_raw_format) {
+		for (i = 0; i < VL53L8CX_RESOLUTION_8X8; i++) {
+#ifndef VL53L8CX_DISABLE_AMBIENT_PER_SPAD
+			p_results->ambient_per_spad[i] /= 2048;
+#endif
+			for (j = 0; j < nb; j++) {
+#ifndef VL53L8CX_DISABLE_DISTANCE_MM
+				p_results->distance_mm[(nb * i) + j] /= 4;
+#endif
+#ifndef VL53L8CX_DISABLE_REFLECTANCE_PERCENT
+				p_results->reflectance[(nb * i) + j] /= 2;
+#endif
+#ifndef VL53L8CX_DISABLE_RANGE_SIGMA_MM
+				p_results->range_sigma_mm[(nb * i) + j] /= 128;
+#endif
+#ifndef VL53L8CX_DISABLE_SIGNAL_PER_SPAD
+				p_results->signal_per_spad[(nb * i) + j] /= 2048;
+#endif
+#if !defined(VL53L8CX_DISABLE_NB_TARGET_DETECTED) \
+	&& !defined(VL53L8CX_DISABLE_TARGET_STATUS)
+				/* Target status to 255 if no target is
+				 * detected for this zone */
+				if (p_results->nb_target_detected[i] == 0)
+					p_results->target_status[(nb * i) + j] = 255;
+#endif
+			}
+		}
+#ifndef VL53L8CX_DISABLE_MOTION_INDICATOR
+		for (i = 0; i < 32; i++)
+			p_results->motion_indicator.motion[i] /= 65535;
+#endif
+	}
+
+	/* Check if footer id and header id are matching. This allows to detect
+	 * corrupted frames */
+	memcpy(&header_id, &buffer[0x8], 2);
+	memcpy(&footer_id, &buffer[size - 12], 2);
+	if (header_id != footer_id)
+		status |= VL53L8CX_STATUS_CORRUPTED_FRAME;
+
+	if (p_dev->crc_checksum_for_results_pkt) {
+		memcpy(&crc_from_packet, &buffer[size - 8], 4);
+		if (crc_from_packet != vl53l8cx_generate_crc_checksum(
+				(uint32_t *)(void *)&buffer[4], (size - 12) / 4))
+			status = VL53L8CX_STATUS_CORRUPTED_FRAME;
+	}
+
+	return status;
+}
+
+/* First field of the results with a difference, NULL if none */
+static const char *check_compare(const VL53L8CX_ResultsData *p_a,
+		const VL53L8CX_ResultsData *p_b, uint32_t zones, uint32_t nb)
+{
+	uint32_t n = zones * nb;
+
+#define CHECK_FIELD(field, count) \
+	if (memcmp(p_a->field, p_b->field, sizeof(p_a->field[0]) * (count))) \
+		return #field
+
+	if (p_a->silicon_temp_degc != p_b->silicon_temp_degc)
+		return "silicon_temp_degc";
+#ifndef VL53L8CX_DISABLE_AMBIENT_PER_SPAD
+	CHECK_FIELD(ambient_per_spad, zones);
+#endif
+#ifndef VL53L8CX_DISABLE_NB_TARGET_DETECTED
+	CHECK_FIELD(nb_target_detected, zones);
+#endif
+#ifndef VL53L8CX_DISABLE_NB_SPADS_ENABLED
+	CHECK_FIELD(nb_spads_enabled, zones);
+#endif
+#ifndef VL53L8CX_DISABLE_SIGNAL_PER_SPAD
+	CHECK_FIELD(signal_per_spad, n);
+#endif
+#ifndef VL53L8CX_DISABLE_RANGE_SIGMA_MM
+	CHECK_FIELD(range_sigma_mm, n);
+#endif
+#ifndef VL53L8CX_DISABLE_DISTANCE_MM
+	CHECK_FIELD(distance_mm, n);
+#endif
+#ifndef VL53L8CX_DISABLE_REFLECTANCE_PERCENT
+	CHECK_FIELD(reflectance, n);
+#endif
+#ifndef VL53L8CX_DISABLE_TARGET_STATUS
+	CHECK_FIELD(target_status, n);
+#endif
+#ifndef VL53L8CX_DISABLE_MOTION_INDICATOR
+	if (memcmp(&p_a->motion_indicator, &p_b->motion_indicator,
+			sizeof(p_a->motion_indicator)))
+		return "motion_indicator";
+#endif
+#undef CHECK_FIELD
+
+	return NULL;
+}
+
+#ifndef VL53L8CX_DISABLE_TARGET_STATUS
+/* Non zero if the target status of the view differs from the results. Without
+ * a number of targets block in the frame, the view keeps the status from the
+ * sensor, while vl53l8cx_get_ranging_data() marks it from the
+ * nb_target_detected field of the results: it is then not compared */
+static int check_view_target_status(VL53L8CX_Configuration *p_dev,
+		const VL53L8CX_ResultsData *p_results, uint32_t n)
+{
+	const uint8_t *p_data = vl53l8cx_view_target_status(p_dev);
+
+	if (p_data != vl53l8cx_view_target_status(p_dev))
+		return 1;
+	if ((p_data == NULL) || (!p_dev->is_raw_format
+			&& (vl53l8cx_view_nb_target_detected(p_dev) == NULL)))
+		return 0;
+	return memcmp(p_data, p_results->target_status, n) != 0;
+}
+#endif
+
+/* First output of the results view with a difference to the results, NULL
+ * if none. The outputs absent from the frame are not compared. The target
+ * status is read before or after the number of targets, both orders of the
+ * conversion in place are covered, and each output is read twice */
+static const char *check_view(VL53L8CX_Configuration *p_dev,
+		const VL53L8CX_ResultsData *p_results, uint32_t zones,
+		uint32_t order)
+{
+	uint32_t n = zones * p_dev->nb_target_per_zone;
+	const void *p_data;
+
+#define CHECK_VIEW(field, count) \
+	p_data = vl53l8cx_view_##field(p_dev); \
+	if ((p_data != vl53l8cx_view_##field(p_dev)) || ((p_data != NULL) \
+		&& memcmp(p_data, p_results->field, \
+			sizeof(p_results->field[0]) * (count)))) \
+		return "view " #field
+
+#ifndef VL53L8CX_DISABLE_TARGET_STATUS
+	if ((order % 2) && check_view_target_status(p_dev, p_results, n))
+		return "view target_status";
+#endif
+	p_data = vl53l8cx_view_silicon_temp_degc(p_dev);
+	if ((p_data != NULL) && (*(const int8_t *)p_data
+			!= p_results->silicon_temp_degc))
+		return "view silicon_temp_degc";
+#ifndef VL53L8CX_DISABLE_AMBIENT_PER_SPAD
+	CHECK_VIEW(ambient_per_spad, zones);
+#endif
+#ifndef VL53L8CX_DISABLE_NB_TARGET_DETECTED
+	CHECK_VIEW(nb_target_detected,
+		zones);
+#endif
+#ifndef VL53L8CX_DISABLE_NB_SPADS_ENABLED
+	CHECK_VIEW(nb_spads_enabled, zones);
+#endif
+#ifndef VL53L8CX_DISABLE_SIGNAL_PER_SPAD
+	CHECK_VIEW(signal_per_spad, n);
+#endif
+#ifndef VL53L8CX_DISABLE_RANGE_SIGMA_MM
+	CHECK_VIEW(range_sigma_mm, n);
+#endif
+#ifndef VL53L8CX_DISABLE_DISTANCE_MM
+	CHECK_VIEW(distance_mm, n);
+#endif
+#ifndef VL53L8CX_DISABLE_REFLECTANCE_PERCENT
+	CHECK_VIEW(reflectance, n);
+#endif
+#ifndef VL53L8CX_DISABLE_TARGET_STATUS
+	if (!(order % 2) && check_view_target_status(p_dev, p_results, n))
+		return "view target_status";
+#endif
+#ifndef VL53L8CX_DISABLE_MOTION_INDICATOR
+	p_data = vl53l8cx_view_motion_indicator(p_dev);
+	if ((p_data != vl53l8cx_view_motion_indicator(p_dev))
+		|| ((p_data != NULL) && memcmp(p_data,
+			&p_results->motion_indicator,
+			sizeof(p_results->motion_indicator))))
+		return "view motion_indicator";
+#endif
+#undef CHECK_VIEW
+
+	return NULL;
+}
+
+static uint32_t seed = 1;
+
+static uint32_t check_random(void)
+{
+	seed ^= seed << 13;
+	seed ^= seed >> 17;
+	seed ^= seed << 5;
+	return seed;
+}
+
+static VL53L8CX_Configuration Dev, Check;
+static uint32_t nb_zones, nb_checks, nb_corrupted, nb_errors;
+
+/* Decodes the frame of the checked device with both decoders, and with the
+ * results view of the driver */
+static void check_frame(const char *name, uint32_t frame, uint32_t fuzz)
+{
+	static VL53L8CX_ResultsData Results, Baseline;
+	const char *field = NULL;
+	uint8_t status, baseline_status, view_status;
+
+	memset(&Results, 0, sizeof(Results));
+	memset(&Baseline, 0, sizeof(Baseline));
+	status = vl53l8cx_get_ranging_data(&Check, &Results);
+	baseline_status = baseline_get_ranging_data(&Check, checked.frame,
+		&Baseline);
+	nb_checks++;
+	if (baseline_status != VL53L8CX_STATUS_OK)
+		nb_corrupted++;
+
+	if (status == baseline_status)
+		field = check_compare(&Results, &Baseline, nb_zones,
+			Check.nb_target_per_zone);
+	view_status = vl53l8cx_get_ranging_view(&Check);
+	if ((field == NULL) && (view_status == status))
+		field = check_view(&Check, &Results, nb_zones, fuzz);
+	if ((status != baseline_status) || (view_status != status)
+		|| (field != NULL)) {
+		if (nb_errors < 10)
+			printf("%s frame %u fuzz %u: status %u/%u/%u %s\n",
+				name, frame, fuzz, status, baseline_status,
+				view_status, (field != NULL) ? field : "");
+		nb_errors++;
+	}
+}
+
+/* Replaces the payloads of the blocks with random bytes, returns the number
+ * of block headers found */
+static uint32_t check_fuzz_payloads(const uint8_t *p_good, uint32_t size,
+		uint32_t *p_headers)
+{
+	uint32_t position = 16, nb_headers = 0, word, type, msize, i;
+
+	while ((position + 4) <= (size - 8)) {
+		word = ((uint32_t)p_good[position] << 24)
+			| ((uint32_t)p_good[position + 1] << 16)
+			| ((uint32_t)p_good[position + 2] << 8)
+			| (uint32_t)p_good[position + 3];
+		type = word & 0xf;
+		msize = ((type > 1) && (type < 0xd))
+			? type * ((word >> 4) & 0xfff) : (word >> 4) & 0xfff;
+		if ((position + 4 + msize) > (size - 8))
+			break;
+		if (nb_headers < CHECK_MAX_BLOCKS)
+			p_headers[nb_headers++] = position;
+		for (i = 0; i < msize; i++)
+			checked.frame[position + 4 + i] = (uint8_t)check_random();
+		position += 4 + msize;
+	}
+
+	return nb_headers;
+}
+
+static int check_config(uint8_t resolution, uint8_t crc, uint8_t nb,
+		uint8_t raw)
+{
+	static uint8_t good[VL53L8CX_TEMPORARY_BUFFER_SIZE];
+	VL53L8CX_Platform platform;
+	uint32_t headers[CHECK_MAX_BLOCKS], nb_headers, size, frame, fuzz, i;
+	uint8_t layout_nb_blocks, status;
+	char name[32];
+
+	snprintf(name, sizeof(name), "%ux%u crc=%u nb=%u raw=%u",
+		resolution == VL53L8CX_RESOLUTION_4X4 ? 4 : 8,
+		resolution == VL53L8CX_RESOLUTION_4X4 ? 4 : 8, crc, nb, raw);
+
+	status = vl53l8cx_set_resolution(&Dev, resolution);
+	status |= vl53l8cx_set_results_crc(&Dev, crc);
+	status |= vl53l8cx_set_nb_target_per_zone(&Dev, nb);
+	status |= vl53l8cx_set_raw_format(&Dev, raw);
+	status |= vl53l8cx_set_ranging_frequency_hz(&Dev,
+		resolution == VL53L8CX_RESOLUTION_4X4 ? 60 : 15);
+	status |= vl53l8cx_start_ranging(&Dev);
+	if (status) {
+		printf("%s: emulator ranging failed\n", name);
+		return -1;
+	}
+
+	/* Same configuration and frame layout, on the checked frame */
+	platform = Check.platform;
+	Check = Dev;
+	Check.platform = platform;
+	size = Dev.data_read_size;
+	checked.size = size;
+	nb_zones = resolution;
+
+	for (frame = 0; frame < CHECK_NB_FRAMES; frame++) {
+		if (!VL53L8CX_wait_for_dataready(&Dev.platform)
+			|| VL53L8CX_RdMulti(&Dev.platform, 0x0, good, size)) {
+			printf("%s: emulator frame %u failed\n", name, frame);
+			return -1;
+		}
+		memcpy(checked.frame, good, size);
+		check_frame(name, frame, 0);
+
+		for (fuzz = 1; fuzz <= CHECK_NB_FUZZ; fuzz++) {
+			memcpy(checked.frame, good, size);
+			nb_headers = check_fuzz_payloads(good, size, headers);
+			if (fuzz % 2)
+				checked.frame[size - 9] ^= 1;
+			/* Any word covered by the CRC */
+			if ((fuzz % 7) == 3)
+				checked.frame[(check_random() % 2)
+					? 4 + (check_random() % 12)
+					: size - 16 + (check_random() % 8)] ^=
+					(uint8_t)(1 + (check_random() % 255));
+			/* Unknown block: the known positions do not match */
+			if (((fuzz % 5) == 0) && (nb_headers != 0)) {
+				i = headers[check_random() % nb_headers];
+				checked.frame[i] = 0;
+				checked.frame[i + 1] = 0;
+			}
+			/* Block headers walk */
+			layout_nb_blocks = Check.layout_nb_blocks;
+			if ((fuzz % 3) == 0)
+				Check.layout_nb_blocks = 0;
+			check_frame(name, frame, fuzz);
+			Check.layout_nb_blocks = layout_nb_blocks;
+		}
+	}
+
+	return vl53l8cx_stop_ranging(&Dev) ? -1 : 0;
+}
+
+int main(int argc, char ** argv)
+{
+	static const uint8_t resolutions[] = {VL53L8CX_RESOLUTION_4X4,
+		VL53L8CX_RESOLUTION_8X8};
+	VL53L8CX_EmulatorScene scene;
+	uint32_t i;
+	uint8_t resolution, crc, nb, raw;
+
+	if (argc >= 2)
+		seed = (uint32_t)atoi(argv[1]) | 1U;
+
+	memset(&Dev, 0, sizeof(Dev));
+	Dev.platform.transport = &VL53L8CX_EmulatorTransport;
+	if (vl53l8cx_comms_init(&Dev.platform) || vl53l8cx_init(&Dev)) {
+		printf("VL53L8CX emulator init failed\n");
+		return -1;
+	}
+
+	memset(&scene, 0, sizeof(scene));
+	for (i = 0; i < VL53L8CX_EMULATOR_NB_ZONES; i++) {
+		scene.distance_mm[i] = (i % 7 == 3) ? 0 : (uint16_t)((i * 97) % 4000);
+		scene.reflectance_percent[i] = (uint8_t)i;
+	}
+	scene.ambient_kcps_per_spad = 9;
+	scene.silicon_temp_degc = -5;
+	scene.noise_mm = 20;
+	scene.corrupt_percent = 10;
+	scene.seed = seed;
+	(void)VL53L8CX_EmulatorSetScene(&Dev.platform, &scene);
+
+	memset(&Check, 0, sizeof(Check));
+	Check.platform.transport = &FrameTransport;
+	Check.platform.transport_data = &checked;
+	if (vl53l8cx_comms_init(&Check.platform)) {
+		printf("VL53L8CX checked frame init failed\n");
+		return -1;
+	}
+
+	for (i = 0; i < sizeof(resolutions); i++) {
+		resolution = resolutions[i];
+		for (crc = 0; crc <= 1; crc++)
+			for (nb = 1; nb <= VL53L8CX_NB_TARGET_PER_ZONE; nb++)
+				for (raw = 0; raw <= 1; raw++)
+					if (check_config(resolution, crc, nb, raw))
+						return -1;
+	}
+
+	printf("%u frames checked, %u corrupted, %u differences\n",
+		nb_checks, nb_corrupted, nb_errors);
+	vl53l8cx_comms_close(&Check.platform);
+	vl53l8cx_comms_close(&Dev.platform);
+	return (nb_errors != 0) ? 1 : 0;
+}
@@ -31,6 +31,7 @@ SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 #include <dlfcn.h>
 
 #include <stdio.h>
+#include <stdlib.h>
 #include <string.h>
 
 #include "vl53l8cx_api.h"
@@ -48,7 +49,7 @@ void sighandler(int signal)
 int main(int argc, char ** argv)
 {
 	char choice[20];
-	int status;
+	int status, arg = 1;
 	VL53L8CX_Configuration 	Dev;
 
 	/*********************************/
@@ -57,6 +58,35 @@ int main(int argc, char ** argv)
 
 	/* Initialize channel com */
 	memset(&Dev, 0, sizeof(Dev));
+	/* Emulated sensor: ./menu emulator [<gpiochip> <line> [timeout_ms]]
+	 * Bus trace: ./menu record <trace> [emulator]
+	 *            ./menu replay <trace> [realtime]
+	 * Optional INT line: ./menu <gpiochip> <line> [timeout_ms] */
+	if ((argc >= 2) && (strcmp(argv[1], "emulator") == 0)) {
+		Dev.platform.transport = &VL53L8CX_EmulatorTransport;
+		arg = 2;
+	}
+	else if ((argc >= 3) && ((strcmp(argv[1], "record") == 0)
+		|| (strcmp(argv[1], "replay") == 0))) {
+		strncpy(Dev.platform.trace_file, argv[2], sizeof(Dev.platform.trace_file) - 1);
+		if (strcmp(argv[1], "record") == 0) {
+			Dev.platform.transport = &VL53L8CX_RecorderTransport;
+			if ((argc >= 4) && (strcmp(argv[3], "emulator") == 0))
+				Dev.platform.trace_transport = &VL53L8CX_EmulatorTransport;
+		}
+		else {
+			Dev.platform.transport = &VL53L8CX_ReplayTransport;
+			if ((argc >= 4) && (strcmp(argv[3], "realtime") == 0))
+				Dev.platform.trace_realtime = 1;
+		}
+		arg = argc;
+	}
+	if (argc >= arg + 2) {
+		strncpy(Dev.platform.gpio_chip, argv[arg], sizeof(Dev.platform.gpio_chip) - 1);
+		Dev.platform.gpio_line = (uint32_t)atoi(argv[arg + 1]);
+		if (argc >= arg + 3)
+			Dev.platform.int_timeout_ms = (uint32_t)atoi(argv[arg + 2]);
+	}
 	status = vl53l8cx_comms_init(&Dev.platform);
 	if(status)
 	{
@@ -29,6 +29,28 @@ void sighandler(int signal)
 	exit_main_loop  = 1;
 }
 
+/* Time spent by a device on the bus and waiting for the sensor, to size the
+ * number of sensors sharing a bus */
+static void print_stats(uint8_t dev, VL53L8CX_Platform *p_platform)
+{
+	VL53L8CX_Stats stats;
+	VL53L8CX_OperationStats *p_op;
+	uint64_t bus_us = 0, bus_bytes = 0;
+	uint8_t op;
+
+	VL53L8CX_GetStats(p_platform, &stats);
+	for (op = VL53L8CX_STATS_WR_BYTE; op <= VL53L8CX_STATS_COMMIT; op++) {
+		bus_us += stats.op[op].total_us;
+		bus_bytes += stats.op[op].size;
+	}
+
+	p_op = &stats.op[VL53L8CX_STATS_RANGING_DATA];
+	printf("Device #%u: bus %llu bytes in %llu us, sleeps %llu us, %u frames read (max %u us)\n",
+		dev, (unsigned long long)bus_bytes, (unsigned long long)bus_us,
+		(unsigned long long)stats.op[VL53L8CX_STATS_SLEEP].total_us,
+		p_op->count, p_op->max_us);
+}
+
 int main(int argc, char ** argv)
 {
 	#define NB_OF_DEV 2
@@ -42,15 +64,20 @@ int main(int argc, char ** argv)
 	/*********************************/
 
 	memset(&Dev, 0, sizeof(Dev));
+	Dev[0].platform.transport = &VL53L8CX_SpiTransport;
 	Dev[0].platform.spi_num = 0;
 	Dev[0].platform.spi_cs = 0;
 
+	Dev[1].platform.transport = &VL53L8CX_SpiTransport;
 	Dev[1].platform.spi_num = 0;
 	Dev[1].platform.spi_cs = 1;
 
-	//Dev[2].platform.spi_num = 1;
-	//Dev[2].platform.spi_cs = 0;
+	/* Each device can use another transport, e.g. an I2C sensor handled by
+	 * the kernel module */
+	//Dev[2].platform.transport = &VL53L8CX_KernelTransport;
+	//strcpy(Dev[2].platform.device, "/dev/stmvl53l8cx1");
 
+	//Dev[3].platform.transport = &VL53L8CX_SpiTransport;
 	//Dev[3].platform.spi_num = 1;
 	//Dev[3].platform.spi_cs = 2;
 
@@ -59,7 +86,7 @@ int main(int argc, char ** argv)
 		status = vl53l8cx_comms_init(&Dev[i].platform);
 		if(status)
 		{
-			printf("VL53L8CX comms init failed on spidev%d.%d\n", Dev[i].platform.spi_num, Dev[i].platform.spi_cs);
+			printf("VL53L8CX comms init failed on device #%d (%s)\n", i, Dev[i].platform.transport->name);
 			return -1;
 		}
 	}
@@ -119,6 +146,7 @@ int main(int argc, char ** argv)
 
 	for (i=0; i< NB_OF_DEV; i++)
 	{
+		print_stats(i, &Dev[i].platform);
 		vl53l8cx_comms_close(&Dev[i].platform);
 	}
 
@@ -0,0 +1,32 @@
+/**
+  *
+  * Copyright (c) 2023 STMicroelectronics.
+  * All rights reserved.
+  *
+  * This software is licensed under terms that can be found in the LICENSE file
+  * in the root directory of this software component.
+  * If no LICENSE file comes with this software, it is provided AS-IS.
+  *
+  ******************************************************************************
+  */
+
+#include <stdio.h>
+#include <string.h>
+
+#include "vl53l8cx_api.h"
+
+/* Print a bus trace written with ./menu record: ./trace <trace> [time] */
+int main(int argc, char ** argv)
+{
+	uint8_t with_time = 0;
+
+	if (argc < 2) {
+		printf("Usage: %s <trace> [time]\n", argv[0]);
+		return -1;
+	}
+
+	if ((argc >= 3) && (strcmp(argv[2], "time") == 0))
+		with_time = 1;
+
+	return (VL53L8CX_TraceDump(argv[1], with_time) == 0) ? 0 : -1;
+}
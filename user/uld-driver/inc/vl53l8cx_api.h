@@ -70,7 +70,9 @@
  * is recommended when the device needs to quickly wake-up.
  * - VL53L8CX_POWER_MODE_DEEP_SLEEP: This mode clears all memory, by consequence the firmware,
  * the configuration and the calibration are lost. It is recommended when the device sleeps during
- * a long time as it consumes a very low current consumption.
+ * a long time as it consumes a very low current consumption. When waking up from deep sleep,
+ * the driver downloads the firmware again if needed, and restores the calibration and the
+ * configuration set through the API (plugin settings must be set again).
  * Both modes can be changed using function vl53l8cx_set_power_mode().
  */
 
@@ -86,6 +88,51 @@
 #define VL53L8CX_CRC_RESULTS_PKT_OFF	((uint8_t) 0U)
 #define VL53L8CX_CRC_RESULTS_PKT_ON		((uint8_t) 1U)
 
+/**
+ * @brief Macros VL53L8CX_OUTPUT_* are the outputs of a ranging session, that
+ * can be combined with vl53l8cx_set_outputs() before vl53l8cx_start_ranging().
+ * Only the outputs not disabled in the 'platform.h' file can be enabled, they
+ * are all enabled by default. Metadata and common data are always sent.
+ */
+
+#define VL53L8CX_OUTPUT_AMBIENT_PER_SPAD		((uint16_t) 0x0008U)
+#define VL53L8CX_OUTPUT_NB_SPADS_ENABLED		((uint16_t) 0x0010U)
+#define VL53L8CX_OUTPUT_NB_TARGET_DETECTED		((uint16_t) 0x0020U)
+#define VL53L8CX_OUTPUT_SIGNAL_PER_SPAD			((uint16_t) 0x0040U)
+#define VL53L8CX_OUTPUT_RANGE_SIGMA_MM			((uint16_t) 0x0080U)
+#define VL53L8CX_OUTPUT_DISTANCE_MM				((uint16_t) 0x0100U)
+#define VL53L8CX_OUTPUT_REFLECTANCE_PERCENT		((uint16_t) 0x0200U)
+#define VL53L8CX_OUTPUT_TARGET_STATUS			((uint16_t) 0x0400U)
+#define VL53L8CX_OUTPUT_MOTION_INDICATOR		((uint16_t) 0x0800U)
+
+/**
+ * @brief Macros used to poll the firmware answers. The status is read once
+ * right after the command, then the polling interval starts at
+ * VL53L8CX_POLL_MIN_INTERVAL_US and doubles up to VL53L8CX_POLL_MAX_INTERVAL_US.
+ * The firmware must answer within VL53L8CX_POLL_TIMEOUT_MS.
+ */
+
+#define VL53L8CX_POLL_MIN_INTERVAL_US	((uint32_t) 100U)
+#define VL53L8CX_POLL_MAX_INTERVAL_US	((uint32_t) 10000U)
+#define VL53L8CX_POLL_TIMEOUT_MS		((uint32_t) 2000U)
+
+/**
+ * @brief Maximum time waited for the MCU boot and for the MCU stop in
+ * vl53l8cx_stop_ranging(). All waits also end at the deadline_us of the
+ * device, if set, with status VL53L8CX_STATUS_TIMEOUT_ERROR.
+ */
+
+#define VL53L8CX_MCU_BOOT_TIMEOUT_MS	((uint32_t) 500U)
+#define VL53L8CX_MCU_STOP_TIMEOUT_MS	((uint32_t) 5000U)
+
+/**
+ * @brief Maximum time waited for the firmware to answer the check of the wake
+ * up from deep sleep. A firmware kept in deep sleep answers a DCI read within
+ * a few ms; after this time the firmware is downloaded again.
+ */
+
+#define VL53L8CX_RESUME_CHECK_TIMEOUT_MS	((uint32_t) 10U)
+
 
 /**
  * @brief Macro VL53L8CX_STATUS_OK indicates that VL53L5 sensor has no error.
@@ -104,59 +151,84 @@
 #define VL53L8CX_STATUS_ERROR				((uint8_t) 255U)
 
 /**
- * @brief Definitions for Range results block headers
+ * @brief Definitions for Range results block headers. The per target results
+ * are not at the same place with 1 target per zone (suffix _1T) and with more
+ * targets per zone (suffix _NT). The macros without suffix correspond to
+ * VL53L8CX_NB_TARGET_PER_ZONE.
  */
 
-#if VL53L8CX_NB_TARGET_PER_ZONE == 1
-
 #define VL53L8CX_START_BH				((uint32_t)0x0000000DU)
 #define VL53L8CX_METADATA_BH			((uint32_t)0x54B400C0U)
 #define VL53L8CX_COMMONDATA_BH			((uint32_t)0x54C00040U)
 #define VL53L8CX_AMBIENT_RATE_BH		((uint32_t)0x54D00104U)
 #define VL53L8CX_SPAD_COUNT_BH			((uint32_t)0x55D00404U)
-#define VL53L8CX_NB_TARGET_DETECTED_BH	((uint32_t)0xDB840401U)
-#define VL53L8CX_SIGNAL_RATE_BH			((uint32_t)0xDBC40404U)
-#define VL53L8CX_RANGE_SIGMA_MM_BH		((uint32_t)0xDEC40402U)
-#define VL53L8CX_DISTANCE_BH			((uint32_t)0xDF440402U)
-#define VL53L8CX_REFLECTANCE_BH			((uint32_t)0xE0440401U)
-#define VL53L8CX_TARGET_STATUS_BH		((uint32_t)0xE0840401U)
-#define VL53L8CX_MOTION_DETECT_BH		((uint32_t)0xD85808C0U)
 
 #define VL53L8CX_METADATA_IDX			((uint16_t)0x54B4U)
 #define VL53L8CX_SPAD_COUNT_IDX			((uint16_t)0x55D0U)
 #define VL53L8CX_AMBIENT_RATE_IDX		((uint16_t)0x54D0U)
-#define VL53L8CX_NB_TARGET_DETECTED_IDX	((uint16_t)0xDB84U)
-#define VL53L8CX_SIGNAL_RATE_IDX		((uint16_t)0xDBC4U)
-#define VL53L8CX_RANGE_SIGMA_MM_IDX		((uint16_t)0xDEC4U)
-#define VL53L8CX_DISTANCE_IDX			((uint16_t)0xDF44U)
-#define VL53L8CX_REFLECTANCE_EST_PC_IDX	((uint16_t)0xE044U)
-#define VL53L8CX_TARGET_STATUS_IDX		((uint16_t)0xE084U)
-#define VL53L8CX_MOTION_DETEC_IDX		((uint16_t)0xD858U)
 
-#else
-#define VL53L8CX_START_BH				((uint32_t)0x0000000DU)
-#define VL53L8CX_METADATA_BH			((uint32_t)0x54B400C0U)
-#define VL53L8CX_COMMONDATA_BH			((uint32_t)0x54C00040U)
-#define VL53L8CX_AMBIENT_RATE_BH		((uint32_t)0x54D00104U)
-#define VL53L8CX_NB_TARGET_DETECTED_BH	((uint32_t)0x57D00401U)
-#define VL53L8CX_SPAD_COUNT_BH			((uint32_t)0x55D00404U)
-#define VL53L8CX_SIGNAL_RATE_BH			((uint32_t)0x58900404U)
-#define VL53L8CX_RANGE_SIGMA_MM_BH		((uint32_t)0x64900402U)
-#define VL53L8CX_DISTANCE_BH			((uint32_t)0x66900402U)
-#define VL53L8CX_REFLECTANCE_BH			((uint32_t)0x6A900401U)
-#define VL53L8CX_TARGET_STATUS_BH		((uint32_t)0x6B900401U)
-#define VL53L8CX_MOTION_DETECT_BH		((uint32_t)0xCC5008C0U)
+#define VL53L8CX_NB_TARGET_DETECTED_BH_1T	((uint32_t)0xDB840401U)
+#define VL53L8CX_SIGNAL_RATE_BH_1T		((uint32_t)0xDBC40404U)
+#define VL53L8CX_RANGE_SIGMA_MM_BH_1T	((uint32_t)0xDEC40402U)
+#define VL53L8CX_DISTANCE_BH_1T			((uint32_t)0xDF440402U)
+#define VL53L8CX_REFLECTANCE_BH_1T		((uint32_t)0xE0440401U)
+#define VL53L8CX_TARGET_STATUS_BH_1T	((uint32_t)0xE0840401U)
+#define VL53L8CX_MOTION_DETECT_BH_1T	((uint32_t)0xD85808C0U)
+
+#define VL53L8CX_NB_TARGET_DETECTED_IDX_1T	((uint16_t)0xDB84U)
+#define VL53L8CX_SIGNAL_RATE_IDX_1T		((uint16_t)0xDBC4U)
+#define VL53L8CX_RANGE_SIGMA_MM_IDX_1T	((uint16_t)0xDEC4U)
+#define VL53L8CX_DISTANCE_IDX_1T		((uint16_t)0xDF44U)
+#define VL53L8CX_REFLECTANCE_EST_PC_IDX_1T	((uint16_t)0xE044U)
+#define VL53L8CX_TARGET_STATUS_IDX_1T	((uint16_t)0xE084U)
+#define VL53L8CX_MOTION_DETEC_IDX_1T	((uint16_t)0xD858U)
+
+#define VL53L8CX_NB_TARGET_DETECTED_BH_NT	((uint32_t)0x57D00401U)
+#define VL53L8CX_SIGNAL_RATE_BH_NT		((uint32_t)0x58900404U)
+#define VL53L8CX_RANGE_SIGMA_MM_BH_NT	((uint32_t)0x64900402U)
+#define VL53L8CX_DISTANCE_BH_NT			((uint32_t)0x66900402U)
+#define VL53L8CX_REFLECTANCE_BH_NT		((uint32_t)0x6A900401U)
+#define VL53L8CX_TARGET_STATUS_BH_NT	((uint32_t)0x6B900401U)
+#define VL53L8CX_MOTION_DETECT_BH_NT	((uint32_t)0xCC5008C0U)
+
+#define VL53L8CX_NB_TARGET_DETECTED_IDX_NT	((uint16_t)0x57D0U)
+#define VL53L8CX_SIGNAL_RATE_IDX_NT		((uint16_t)0x5890U)
+#define VL53L8CX_RANGE_SIGMA_MM_IDX_NT	((uint16_t)0x6490U)
+#define VL53L8CX_DISTANCE_IDX_NT		((uint16_t)0x6690U)
+#define VL53L8CX_REFLECTANCE_EST_PC_IDX_NT	((uint16_t)0x6A90U)
+#define VL53L8CX_TARGET_STATUS_IDX_NT	((uint16_t)0x6B90U)
+#define VL53L8CX_MOTION_DETEC_IDX_NT	((uint16_t)0xCC50U)
 
-#define VL53L8CX_METADATA_IDX			((uint16_t)0x54B4U)
-#define VL53L8CX_SPAD_COUNT_IDX			((uint16_t)0x55D0U)
-#define VL53L8CX_AMBIENT_RATE_IDX		((uint16_t)0x54D0U)
-#define VL53L8CX_NB_TARGET_DETECTED_IDX	((uint16_t)0x57D0U)
-#define VL53L8CX_SIGNAL_RATE_IDX		((uint16_t)0x5890U)
-#define VL53L8CX_RANGE_SIGMA_MM_IDX		((uint16_t)0x6490U)
-#define VL53L8CX_DISTANCE_IDX			((uint16_t)0x6690U)
-#define VL53L8CX_REFLECTANCE_EST_PC_IDX	((uint16_t)0x6A90U)
-#define VL53L8CX_TARGET_STATUS_IDX		((uint16_t)0x6B90U)
-#define VL53L8CX_MOTION_DETEC_IDX		((uint16_t)0xCC50U)
+#if VL53L8CX_NB_TARGET_PER_ZONE == 1
+#define VL53L8CX_NB_TARGET_DETECTED_BH	VL53L8CX_NB_TARGET_DETECTED_BH_1T
+#define VL53L8CX_SIGNAL_RATE_BH			VL53L8CX_SIGNAL_RATE_BH_1T
+#define VL53L8CX_RANGE_SIGMA_MM_BH		VL53L8CX_RANGE_SIGMA_MM_BH_1T
+#define VL53L8CX_DISTANCE_BH			VL53L8CX_DISTANCE_BH_1T
+#define VL53L8CX_REFLECTANCE_BH			VL53L8CX_REFLECTANCE_BH_1T
+#define VL53L8CX_TARGET_STATUS_BH		VL53L8CX_TARGET_STATUS_BH_1T
+#define VL53L8CX_MOTION_DETECT_BH		VL53L8CX_MOTION_DETECT_BH_1T
+#define VL53L8CX_NB_TARGET_DETECTED_IDX	VL53L8CX_NB_TARGET_DETECTED_IDX_1T
+#define VL53L8CX_SIGNAL_RATE_IDX		VL53L8CX_SIGNAL_RATE_IDX_1T
+#define VL53L8CX_RANGE_SIGMA_MM_IDX		VL53L8CX_RANGE_SIGMA_MM_IDX_1T
+#define VL53L8CX_DISTANCE_IDX			VL53L8CX_DISTANCE_IDX_1T
+#define VL53L8CX_REFLECTANCE_EST_PC_IDX	VL53L8CX_REFLECTANCE_EST_PC_IDX_1T
+#define VL53L8CX_TARGET_STATUS_IDX		VL53L8CX_TARGET_STATUS_IDX_1T
+#define VL53L8CX_MOTION_DETEC_IDX		VL53L8CX_MOTION_DETEC_IDX_1T
+#else
+#define VL53L8CX_NB_TARGET_DETECTED_BH	VL53L8CX_NB_TARGET_DETECTED_BH_NT
+#define VL53L8CX_SIGNAL_RATE_BH			VL53L8CX_SIGNAL_RATE_BH_NT
+#define VL53L8CX_RANGE_SIGMA_MM_BH		VL53L8CX_RANGE_SIGMA_MM_BH_NT
+#define VL53L8CX_DISTANCE_BH			VL53L8CX_DISTANCE_BH_NT
+#define VL53L8CX_REFLECTANCE_BH			VL53L8CX_REFLECTANCE_BH_NT
+#define VL53L8CX_TARGET_STATUS_BH		VL53L8CX_TARGET_STATUS_BH_NT
+#define VL53L8CX_MOTION_DETECT_BH		VL53L8CX_MOTION_DETECT_BH_NT
+#define VL53L8CX_NB_TARGET_DETECTED_IDX	VL53L8CX_NB_TARGET_DETECTED_IDX_NT
+#define VL53L8CX_SIGNAL_RATE_IDX		VL53L8CX_SIGNAL_RATE_IDX_NT
+#define VL53L8CX_RANGE_SIGMA_MM_IDX		VL53L8CX_RANGE_SIGMA_MM_IDX_NT
+#define VL53L8CX_DISTANCE_IDX			VL53L8CX_DISTANCE_IDX_NT
+#define VL53L8CX_REFLECTANCE_EST_PC_IDX	VL53L8CX_REFLECTANCE_EST_PC_IDX_NT
+#define VL53L8CX_TARGET_STATUS_IDX		VL53L8CX_TARGET_STATUS_IDX_NT
+#define VL53L8CX_MOTION_DETEC_IDX		VL53L8CX_MOTION_DETEC_IDX_NT
 #endif
 
 
@@ -188,6 +260,10 @@
 #define VL53L8CX_DCI_PIPE_CONTROL		((uint16_t)0xDB80U)
 #define VL53L8CX_DCI_CRC_RESULTS_PKT     ((uint16_t)0xE0C4U)
 
+/* Host copy of the DCI configuration blocks, see vl53l8cx_dci_read_data() */
+#define VL53L8CX_DCI_SHADOW_NB_BLOCKS	((uint8_t)12U)
+#define VL53L8CX_DCI_SHADOW_SIZE		((uint16_t)120U)
+
 #define VL53L8CX_UI_CMD_STATUS			((uint16_t)0x2C00U)
 #define VL53L8CX_UI_CMD_START			((uint16_t)0x2C04U)
 #define VL53L8CX_UI_CMD_END				((uint16_t)0x2FFFU)
@@ -198,56 +274,74 @@
 
 #ifndef VL53L8CX_DISABLE_AMBIENT_PER_SPAD
 #define L5CX_AMB_SIZE	260U
+#define L5CX_AMB_OUTPUT	VL53L8CX_OUTPUT_AMBIENT_PER_SPAD
 #else
 #define L5CX_AMB_SIZE	0U
+#define L5CX_AMB_OUTPUT	((uint16_t)0U)
 #endif
 
 #ifndef VL53L8CX_DISABLE_NB_SPADS_ENABLED
 #define L5CX_SPAD_SIZE	260U
+#define L5CX_SPAD_OUTPUT	VL53L8CX_OUTPUT_NB_SPADS_ENABLED
 #else
 #define L5CX_SPAD_SIZE	0U
+#define L5CX_SPAD_OUTPUT	((uint16_t)0U)
 #endif
 
 #ifndef VL53L8CX_DISABLE_NB_TARGET_DETECTED
 #define L5CX_NTAR_SIZE	68U
+#define L5CX_NTAR_OUTPUT	VL53L8CX_OUTPUT_NB_TARGET_DETECTED
 #else
 #define L5CX_NTAR_SIZE	0U
+#define L5CX_NTAR_OUTPUT	((uint16_t)0U)
 #endif
 
 #ifndef VL53L8CX_DISABLE_SIGNAL_PER_SPAD
 #define L5CX_SPS_SIZE ((256U * VL53L8CX_NB_TARGET_PER_ZONE) + 4U)
+#define L5CX_SPS_OUTPUT	VL53L8CX_OUTPUT_SIGNAL_PER_SPAD
 #else
 #define L5CX_SPS_SIZE	0U
+#define L5CX_SPS_OUTPUT	((uint16_t)0U)
 #endif
 
 #ifndef VL53L8CX_DISABLE_RANGE_SIGMA_MM
 #define L5CX_SIGR_SIZE ((128U * VL53L8CX_NB_TARGET_PER_ZONE) + 4U)
+#define L5CX_SIGR_OUTPUT	VL53L8CX_OUTPUT_RANGE_SIGMA_MM
 #else
 #define L5CX_SIGR_SIZE	0U
+#define L5CX_SIGR_OUTPUT	((uint16_t)0U)
 #endif
 
 #ifndef VL53L8CX_DISABLE_DISTANCE_MM
 #define L5CX_DIST_SIZE ((128U * VL53L8CX_NB_TARGET_PER_ZONE) + 4U)
+#define L5CX_DIST_OUTPUT	VL53L8CX_OUTPUT_DISTANCE_MM
 #else
 #define L5CX_DIST_SIZE	0U
+#define L5CX_DIST_OUTPUT	((uint16_t)0U)
 #endif
 
 #ifndef VL53L8CX_DISABLE_REFLECTANCE_PERCENT
 #define L5CX_RFLEST_SIZE ((64U *VL53L8CX_NB_TARGET_PER_ZONE) + 4U)
+#define L5CX_RFLEST_OUTPUT	VL53L8CX_OUTPUT_REFLECTANCE_PERCENT
 #else
 #define L5CX_RFLEST_SIZE	0U
+#define L5CX_RFLEST_OUTPUT	((uint16_t)0U)
 #endif
 
 #ifndef VL53L8CX_DISABLE_TARGET_STATUS
 #define L5CX_STA_SIZE ((64U  *VL53L8CX_NB_TARGET_PER_ZONE) + 4U)
+#define L5CX_STA_OUTPUT	VL53L8CX_OUTPUT_TARGET_STATUS
 #else
 #define L5CX_STA_SIZE	0U
+#define L5CX_STA_OUTPUT	((uint16_t)0U)
 #endif
 
 #ifndef VL53L8CX_DISABLE_MOTION_INDICATOR
 #define L5CX_MOT_SIZE	144U
+#define L5CX_MOT_OUTPUT	VL53L8CX_OUTPUT_MOTION_INDICATOR
 #else
 #define L5CX_MOT_SIZE	0U
+#define L5CX_MOT_OUTPUT	((uint16_t)0U)
 #endif
 
 /**
@@ -261,6 +355,16 @@
 	+ L5CX_SIGR_SIZE + L5CX_DIST_SIZE + L5CX_RFLEST_SIZE + L5CX_STA_SIZE \
 	+ L5CX_MOT_SIZE + 20U)
 
+/**
+ * @brief Macro VL53L8CX_OUTPUTS_AVAILABLE indicates the outputs not disabled in
+ * the 'platform.h' file, that can be enabled by vl53l8cx_set_outputs().
+ */
+
+#define VL53L8CX_OUTPUTS_AVAILABLE ((uint16_t)(L5CX_AMB_OUTPUT \
+	| L5CX_SPAD_OUTPUT | L5CX_NTAR_OUTPUT | L5CX_SPS_OUTPUT \
+	| L5CX_SIGR_OUTPUT | L5CX_DIST_OUTPUT | L5CX_RFLEST_OUTPUT \
+	| L5CX_STA_OUTPUT | L5CX_MOT_OUTPUT))
+
 /**
  * @brief Macro VL53L8CX_TEMPORARY_BUFFER_SIZE can be used to know the size of
  * the temporary buffer. The minimum size is 1024, and the maximum depends of
@@ -274,6 +378,53 @@
 #endif
 
 
+/**
+ * @brief Macro VL53L8CX_NB_LAYOUT_BLOCKS indicates the maximum number of blocks
+ * of a results frame: the outputs sent to the firmware, without the start
+ * block.
+ */
+
+#define VL53L8CX_NB_LAYOUT_BLOCKS	((uint8_t)11U)
+
+/**
+ * @brief Structure VL53L8CX_BlockLayout describes a block of the results
+ * frame, as programmed by vl53l8cx_start_ranging().
+ */
+
+typedef struct
+{
+	/* Block header expected in the frame */
+	uint32_t	header;
+	/* Position of the block data in the frame, and data size in bytes */
+	uint16_t	offset;
+	uint16_t	size;
+} VL53L8CX_BlockLayout;
+
+/**
+ * @brief Macro VL53L8CX_NB_VIEW_OUTPUTS indicates the number of outputs that
+ * can be accessed through the results view.
+ */
+
+#define VL53L8CX_NB_VIEW_OUTPUTS	((uint8_t)10U)
+
+/**
+ * @brief Structure VL53L8CX_ResultsView locates the outputs of the frame read
+ * by vl53l8cx_get_ranging_view() in the temporary buffer of the device. Each
+ * output is converted in place the first time it is accessed.
+ */
+
+typedef struct
+{
+	/* Position of the data of each output in the temporary buffer, and
+	 * data size in bytes. 0 if the output is not in the frame */
+	uint16_t	offset[VL53L8CX_NB_VIEW_OUTPUTS];
+	uint16_t	size[VL53L8CX_NB_VIEW_OUTPUTS];
+	/* One bit per output already converted */
+	uint16_t	converted;
+	/* Set while the temporary buffer holds the frame */
+	uint8_t		is_valid;
+} VL53L8CX_ResultsView;
+
 /**
  * @brief Structure VL53L8CX_Configuration contains the sensor configuration.
  * User MUST not manually change these field, except for the sensor address.
@@ -295,15 +446,77 @@ typedef struct
 	uint8_t		        offset_data[VL53L8CX_OFFSET_BUFFER_SIZE];
 	/* Xtalk buffer */
 	uint8_t		        xtalk_data[VL53L8CX_XTALK_BUFFER_SIZE];
-	/* Temporary buffer used for internal driver processing */
+	/* Offset and Xtalk data formatted for each resolution, ready to be
+	 * sent to the FW */
+	uint8_t		        offset_upload_4x4[VL53L8CX_OFFSET_BUFFER_SIZE];
+	uint8_t		        offset_upload_8x8[VL53L8CX_OFFSET_BUFFER_SIZE];
+	uint8_t		        xtalk_upload_4x4[VL53L8CX_XTALK_BUFFER_SIZE];
+	uint8_t		        xtalk_upload_8x8[VL53L8CX_XTALK_BUFFER_SIZE];
+	/* Temporary buffer used for internal driver processing. Word aligned,
+	 * as the results view converts the outputs in place */
 	uint8_t		        temp_buffer[VL53L8CX_TEMPORARY_BUFFER_SIZE];
+	/* Set once vl53l8cx_init() has read the NVM: offset and Xtalk buffers
+	 * can be restored when waking up from deep sleep */
+	uint8_t				is_calibration_loaded;
 	/* Auto-stop flag for stopping the sensor */
 	uint8_t				is_auto_stop_enabled;
     /* CRC for results packet */
     uint8_t             crc_checksum_for_results_pkt;
+	/* Outputs of the next ranging session, VL53L8CX_OUTPUT_* bits */
+	uint16_t			outputs;
+	/* Number of targets per zone of the next ranging session, up to
+	 * VL53L8CX_NB_TARGET_PER_ZONE, and results kept in the firmware format
+	 * if set */
+	uint8_t				nb_target_per_zone;
+	uint8_t				is_raw_format;
+	/* Time taken by the firmware to answer the last polled command, and
+	 * longest answer since vl53l8cx_init(), in us */
+	uint32_t			last_answer_time_us;
+	uint32_t			max_answer_time_us;
+	/* Copy of the DCI configuration blocks last read from or written to
+	 * the firmware, one valid bit per block */
+	uint8_t				dci_shadow[VL53L8CX_DCI_SHADOW_SIZE];
+	uint16_t			dci_shadow_valid;
+	/* Configuration staged by vl53l8cx_begin_config(): blocks not sent
+	 * yet, and offset/Xtalk data to send for the new resolution */
+	uint8_t				config_staging;
+	uint8_t				config_caldata_pending;
+	uint16_t			dci_shadow_dirty;
+	/* Frame period and jitter learnt from the stream count when data ready
+	 * is polled, and time of the last frame, in us. The period is seeded
+	 * from the ranging frequency by vl53l8cx_start_ranging() */
+	uint32_t			frame_period_us;
+	uint32_t			frame_jitter_us;
+	uint64_t			frame_ready_us;
+	uint8_t				frame_outliers;
+	/* Blocks of the results frame in the frame order, computed by
+	 * vl53l8cx_start_ranging(). 0 blocks until the ranging is started */
+	VL53L8CX_BlockLayout		layout[VL53L8CX_NB_LAYOUT_BLOCKS];
+	uint8_t				layout_nb_blocks;
+	/* Frame of vl53l8cx_get_ranging_view(), in the temporary buffer */
+	VL53L8CX_ResultsView		view;
+	/* Absolute time, from VL53L8CX_GetTimeUs(), after which every blocking
+	 * wait gives up with VL53L8CX_STATUS_TIMEOUT_ERROR. 0 for no deadline */
+	uint64_t			deadline_us;
 } VL53L8CX_Configuration;
 
 
+/**
+ * @brief Structure VL53L8CX_MotionIndicator contains the motion detector
+ * results.
+ */
+
+typedef struct
+{
+	uint32_t global_indicator_1;
+	uint32_t global_indicator_2;
+	uint8_t	 status;
+	uint8_t	 nb_of_detected_aggregates;
+	uint8_t	 nb_of_aggregates;
+	uint8_t	 spare;
+	uint32_t motion[32];
+} VL53L8CX_MotionIndicator;
+
 /**
  * @brief Structure VL53L8CX_ResultsData contains the ranging results of
  * VL53L8CX. If user wants more than 1 target per zone, the results can be split
@@ -312,7 +525,9 @@ typedef struct
  * , nb_target_detected and nb_spads_enabled).
  * - Per target results : These results are different relative to the detected
  * target (signal_per_spad, range_sigma_mm, distance_mm, reflectance,
- * target_status).
+ * target_status). The results of a zone are followed by the ones of the next
+ * zone, with the number of targets per zone of the device (see
+ * vl53l8cx_set_nb_target_per_zone()).
  */
 
 typedef struct
@@ -367,16 +582,7 @@ typedef struct
 
 	/* Motion detector results */
 #ifndef VL53L8CX_DISABLE_MOTION_INDICATOR
-	struct
-	{
-		uint32_t global_indicator_1;
-		uint32_t global_indicator_2;
-		uint8_t	 status;
-		uint8_t	 nb_of_detected_aggregates;
-		uint8_t	 nb_of_aggregates;
-		uint8_t	 spare;
-		uint32_t motion[32];
-	} motion_indicator;
+	VL53L8CX_MotionIndicator motion_indicator;
 #endif
 
 } VL53L8CX_ResultsData;
@@ -495,6 +701,59 @@ uint8_t vl53l8cx_get_ranging_data(
 		VL53L8CX_Configuration		*p_dev,
 		VL53L8CX_ResultsData		*p_results);
 
+/**
+ * @brief This function reads a new frame, as vl53l8cx_get_ranging_data(), but
+ * without copying the results: they are read through the vl53l8cx_view_*()
+ * functions, which convert each output in place in the temporary buffer the
+ * first time it is accessed. The frame stays valid until the next call of a
+ * function of the driver on this device, except vl53l8cx_check_data_ready().
+ * @param (VL53L8CX_Configuration) *p_dev : VL53L8CX configuration structure.
+ * @return (uint8_t) status : 0 if the frame is successfully read, or 2 if it
+ * is corrupted.
+ */
+
+uint8_t vl53l8cx_get_ranging_view(
+		VL53L8CX_Configuration		*p_dev);
+
+/**
+ * @brief These functions give the outputs of the frame read by
+ * vl53l8cx_get_ranging_view(), with the same format and order as the fields of
+ * VL53L8CX_ResultsData. The arrays are read only.
+ * @param (VL53L8CX_Configuration) *p_dev : VL53L8CX configuration structure.
+ * @return Address of the output in the temporary buffer, or NULL if the output
+ * is not in the frame or the frame is not valid anymore.
+ */
+
+const int8_t *vl53l8cx_view_silicon_temp_degc(
+		VL53L8CX_Configuration		*p_dev);
+
+const uint32_t *vl53l8cx_view_ambient_per_spad(
+		VL53L8CX_Configuration		*p_dev);
+
+const uint8_t *vl53l8cx_view_nb_target_detected(
+		VL53L8CX_Configuration		*p_dev);
+
+const uint32_t *vl53l8cx_view_nb_spads_enabled(
+		VL53L8CX_Configuration		*p_dev);
+
+const uint32_t *vl53l8cx_view_signal_per_spad(
+		VL53L8CX_Configuration		*p_dev);
+
+const uint16_t *vl53l8cx_view_range_sigma_mm(
+		VL53L8CX_Configuration		*p_dev);
+
+const int16_t *vl53l8cx_view_distance_mm(
+		VL53L8CX_Configuration		*p_dev);
+
+const uint8_t *vl53l8cx_view_reflectance(
+		VL53L8CX_Configuration		*p_dev);
+
+const uint8_t *vl53l8cx_view_target_status(
+		VL53L8CX_Configuration		*p_dev);
+
+const VL53L8CX_MotionIndicator *vl53l8cx_view_motion_indicator(
+		VL53L8CX_Configuration		*p_dev);
+
 /**
  * @brief This function gets the current resolution (4x4 or 8x8).
  * @param (VL53L8CX_Configuration) *p_dev : VL53L8CX configuration structure.
@@ -704,9 +963,66 @@ uint8_t vl53l8cx_set_VHV_repeat_count(
 		VL53L8CX_Configuration *p_dev,
 		uint32_t repeat_count);
 
+/**
+ * @brief Inner functions for API and plugins. They format the offset data
+ * (p_dev->offset_data) or the Xtalk data (p_dev->xtalk_data) for both
+ * resolutions, and must be called each time these buffers are modified. The
+ * formatted data is sent by vl53l8cx_set_resolution().
+ * @param (VL53L8CX_Configuration) *p_dev : VL53L8CX configuration structure.
+ */
+
+void vl53l8cx_prepare_offset_data(
+		VL53L8CX_Configuration		*p_dev);
+
+void vl53l8cx_prepare_xtalk_data(
+		VL53L8CX_Configuration		*p_dev);
+
+/**
+ * @brief This function starts staging a configuration change. Until
+ * vl53l8cx_commit_config(), the setters vl53l8cx_set_resolution(),
+ * vl53l8cx_set_ranging_frequency_hz(), vl53l8cx_set_integration_time_ms(),
+ * vl53l8cx_set_sharpener_percent(), vl53l8cx_set_target_order(),
+ * vl53l8cx_set_ranging_mode(), vl53l8cx_set_external_sync_pin_enable() and
+ * vl53l8cx_set_VHV_repeat_count() only update the host copy of the DCI
+ * blocks, and the getters return the staged values. Other functions must not
+ * be used while staging.
+ * @param (VL53L8CX_Configuration) *p_dev : VL53L8CX configuration structure.
+ * @return (uint8_t) status : 0 if OK
+ */
+
+uint8_t vl53l8cx_begin_config(
+		VL53L8CX_Configuration		*p_dev);
+
+/**
+ * @brief This function sends the configuration staged since
+ * vl53l8cx_begin_config(). Each modified DCI block is written once, adjacent
+ * blocks being merged into a single write, then the offset and Xtalk data
+ * are sent once if the resolution was set.
+ * @param (VL53L8CX_Configuration) *p_dev : VL53L8CX configuration structure.
+ * @return (uint8_t) status : 0 if OK
+ */
+
+uint8_t vl53l8cx_commit_config(
+		VL53L8CX_Configuration		*p_dev);
+
+/**
+ * @brief This function drops the host copy of the DCI configuration blocks.
+ * The configuration getters are served from this copy, and the setters only
+ * write the modified block. The copy is dropped by vl53l8cx_init() and after
+ * a Xtalk calibration. It is kept in deep sleep: the wake up restores it if
+ * the firmware was lost. It must also be dropped when the sensor
+ * configuration is changed outside of the driver, for example after a HW
+ * reset of the sensor. A staged configuration is lost.
+ * @param (VL53L8CX_Configuration) *p_dev : VL53L8CX configuration structure.
+ */
+
+void vl53l8cx_dci_invalidate_shadow(
+		VL53L8CX_Configuration		*p_dev);
+
 /**
  * @brief This function can be used to read 'extra data' from DCI. Using a known
- * index, the function fills the casted structure passed in argument.
+ * index, the function fills the casted structure passed in argument. The
+ * configuration blocks are read from the host copy when it is valid.
  * @param (VL53L8CX_Configuration) *p_dev : VL53L8CX configuration structure.
  * @param (uint8_t) *data : This field can be a casted structure, or a simple
  * array. Please note that the FW only accept data of 32 bits. So field data can
@@ -737,6 +1053,85 @@ uint8_t vl53l8cx_set_results_crc(
 		VL53L8CX_Configuration		*p_dev,
 		uint8_t		checksum_setting);
 
+/**
+ * @brief This function selects the outputs of the next ranging sessions, to
+ * read only the results needed by the application. The size of the frames is
+ * computed from them by vl53l8cx_start_ranging(). The fields of
+ * VL53L8CX_ResultsData of the outputs not enabled are not updated.
+ * @param (VL53L8CX_Configuration) *p_dev : VL53L8CX configuration structure.
+ * @param (uint16_t) outputs : Combination of the VL53L8CX_OUTPUT_* macros.
+ * @return (uint8_t) status : 0 if OK, or 127 if an output is not available
+ * (see VL53L8CX_OUTPUTS_AVAILABLE).
+ */
+
+uint8_t vl53l8cx_set_outputs(
+		VL53L8CX_Configuration		*p_dev,
+		uint16_t			outputs);
+
+/**
+ * @brief This function gets the outputs selected for the ranging sessions.
+ * @param (VL53L8CX_Configuration) *p_dev : VL53L8CX configuration structure.
+ * @param (uint16_t) *p_outputs : Combination of the VL53L8CX_OUTPUT_* macros.
+ * @return (uint8_t) status : 0 if OK
+ */
+
+uint8_t vl53l8cx_get_outputs(
+		VL53L8CX_Configuration		*p_dev,
+		uint16_t			*p_outputs);
+
+/**
+ * @brief This function sets the number of targets per zone sent by the sensor,
+ * from 1 to VL53L8CX_NB_TARGET_PER_ZONE (default value), which sizes the
+ * results buffers. The sensor must not be ranging. A lower number of targets
+ * reduces the size of the frames.
+ * @param (VL53L8CX_Configuration) *p_dev : VL53L8CX configuration structure.
+ * @param (uint8_t) nb_target_per_zone : Number of targets per zone.
+ * @return (uint8_t) status : 0 if OK, or 127 if the number of targets is not
+ * valid.
+ */
+
+uint8_t vl53l8cx_set_nb_target_per_zone(
+		VL53L8CX_Configuration		*p_dev,
+		uint8_t				nb_target_per_zone);
+
+/**
+ * @brief This function gets the number of targets per zone sent by the sensor.
+ * @param (VL53L8CX_Configuration) *p_dev : VL53L8CX configuration structure.
+ * @param (uint8_t) *p_nb_target_per_zone : Number of targets per zone.
+ * @return (uint8_t) status : 0 if OK
+ */
+
+uint8_t vl53l8cx_get_nb_target_per_zone(
+		VL53L8CX_Configuration		*p_dev,
+		uint8_t				*p_nb_target_per_zone);
+
+/**
+ * @brief This function selects the format of the results: converted into the
+ * user format (default), or kept in the firmware format which has an increased
+ * precision (default if VL53L8CX_USE_RAW_FORMAT is defined in the 'platform.h'
+ * file). Only the host is configured.
+ * @param (VL53L8CX_Configuration) *p_dev : VL53L8CX configuration structure.
+ * @param (uint8_t) is_raw_format : 1 for the firmware format, 0 for the user
+ * format.
+ * @return (uint8_t) status : 0 if OK
+ */
+
+uint8_t vl53l8cx_set_raw_format(
+		VL53L8CX_Configuration		*p_dev,
+		uint8_t				is_raw_format);
+
+/**
+ * @brief This function gets the format of the results.
+ * @param (VL53L8CX_Configuration) *p_dev : VL53L8CX configuration structure.
+ * @param (uint8_t) *p_is_raw_format : 1 for the firmware format, 0 for the
+ * user format.
+ * @return (uint8_t) status : 0 if OK
+ */
+
+uint8_t vl53l8cx_get_raw_format(
+		VL53L8CX_Configuration		*p_dev,
+		uint8_t				*p_is_raw_format);
+
 /**
  * @brief This function can be used to write 'extra data' to DCI. The data can
  * be simple data, or casted structure.
@@ -15,6 +15,83 @@
 #include "vl53l8cx_api.h"
 #include "vl53l8cx_buffers.h"
 
+/*
+ * Vector instructions used to convert the results, when the compiler targets
+ * them and VL53L8CX_DISABLE_SIMD is not defined in the 'platform.h' file
+ */
+#if !defined(VL53L8CX_DISABLE_SIMD) && defined(__SSE2__)
+#include <emmintrin.h>
+#define VL53L8CX_SIMD_SSE2
+#elif !defined(VL53L8CX_DISABLE_SIMD) && defined(__ARM_NEON) \
+	&& defined(__BYTE_ORDER__) && (__BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__)
+#include <arm_neon.h>
+#define VL53L8CX_SIMD_NEON
+#endif
+
+/*
+ * DCI configuration blocks kept in the host copy. They are only modified by
+ * the host: status blocks (e.g. 0x5440, 0xE0C4) must never be added.
+ */
+static const uint16_t _vl53l8cx_dci_shadow_index[VL53L8CX_DCI_SHADOW_NB_BLOCKS] = {
+	VL53L8CX_DCI_ZONE_CONFIG, VL53L8CX_DCI_FREQ_HZ, VL53L8CX_DCI_INT_TIME,
+	VL53L8CX_DCI_FW_NB_TARGET, VL53L8CX_DCI_RANGING_MODE,
+	VL53L8CX_DCI_DSS_CONFIG, VL53L8CX_DCI_VHV_CONFIG,
+	VL53L8CX_DCI_TARGET_ORDER, VL53L8CX_DCI_SHARPENER,
+	VL53L8CX_DCI_SYNC_PIN, VL53L8CX_DCI_SINGLE_RANGE,
+	VL53L8CX_DCI_PIPE_CONTROL};
+
+static const uint16_t _vl53l8cx_dci_shadow_size[VL53L8CX_DCI_SHADOW_NB_BLOCKS] = {
+	8, 4, 20, 16, 8, 16, 16, 4, 16, 4, 4, 4};
+
+/**
+ * @brief Inner function, not available outside this file. This function is used
+ * to find a DCI block in the host copy. It returns the block number, or -1 if
+ * the block is not kept or is accessed with another size.
+ */
+
+static int8_t _vl53l8cx_dci_shadow_find(
+		uint32_t			index,
+		uint16_t			data_size,
+		uint16_t			*p_offset)
+{
+	int8_t i;
+	uint16_t offset = 0;
+
+	for(i = 0; i < (int8_t)VL53L8CX_DCI_SHADOW_NB_BLOCKS; i++)
+	{
+		if(_vl53l8cx_dci_shadow_index[i] == index)
+		{
+			*p_offset = offset;
+			return (_vl53l8cx_dci_shadow_size[i] == data_size) ? i : -1;
+		}
+		offset += _vl53l8cx_dci_shadow_size[i];
+	}
+
+	return -1;
+}
+
+/**
+ * @brief Inner function, not available outside this file. This function returns
+ * the time at which a wait of timeout_ms started now ends, bounded by the
+ * deadline of the device.
+ */
+
+static uint64_t _vl53l8cx_wait_deadline(
+		VL53L8CX_Configuration	*p_dev,
+		uint32_t				timeout_ms)
+{
+	uint64_t deadline_us = VL53L8CX_GetTimeUs(&(p_dev->platform))
+		+ ((uint64_t)timeout_ms * 1000U);
+
+	if((p_dev->deadline_us != (uint64_t)0)
+		&& (p_dev->deadline_us < deadline_us))
+	{
+		deadline_us = p_dev->deadline_us;
+	}
+
+	return deadline_us;
+}
+
 /**
  * @brief Inner function, not available outside this file. This function is used
  * to wait for an answer from VL53L8CX sensor.
@@ -29,29 +106,60 @@ static uint8_t _vl53l8cx_poll_for_answer(
 		uint8_t					expected_value)
 {
 	uint8_t status = VL53L8CX_STATUS_OK;
-	uint8_t timeout = 0;
-
-	do {
+	uint32_t interval_us = VL53L8CX_POLL_MIN_INTERVAL_US;
+	uint32_t reads = 0;
+	uint64_t start_us, now_us, elapsed_us, deadline_us, stats_us;
+
+	stats_us = VL53L8CX_StatsStart();
+	start_us = VL53L8CX_GetTimeUs(&(p_dev->platform));
+	deadline_us = _vl53l8cx_wait_deadline(p_dev, VL53L8CX_POLL_TIMEOUT_MS);
+	while(1)
+	{
 		status |= VL53L8CX_RdMulti(&(p_dev->platform), address,
 				p_dev->temp_buffer, size);
-		status |= VL53L8CX_WaitMs(&(p_dev->platform), 10);
+		reads++;
+		now_us = VL53L8CX_GetTimeUs(&(p_dev->platform));
+		elapsed_us = now_us - start_us;
 
-		if(timeout >= (uint8_t)200)	/* 2s timeout */
-		{
-			status |= (uint8_t)VL53L8CX_STATUS_TIMEOUT_ERROR;
-			break;
-		}else if((size >= (uint8_t)4) 
+		if((size >= (uint8_t)4)
                          && (p_dev->temp_buffer[2] >= (uint8_t)0x7f))
 		{
 			status |= VL53L8CX_MCU_ERROR;
 			break;
 		}
-		else
+		else if((p_dev->temp_buffer[pos] & mask) == expected_value)
+		{
+			p_dev->last_answer_time_us = (uint32_t)elapsed_us;
+			if(p_dev->last_answer_time_us > p_dev->max_answer_time_us)
+			{
+				p_dev->max_answer_time_us = p_dev->last_answer_time_us;
+			}
+			break;
+		}
+		else if(now_us >= deadline_us)
+		{
+			status |= (uint8_t)VL53L8CX_STATUS_TIMEOUT_ERROR;
+			break;
+		}
+
+		/* Fast answers are caught early, slow ones cost few bus reads */
+		if((now_us + interval_us) > deadline_us)
+		{
+			interval_us = (uint32_t)(deadline_us - now_us);
+		}
+		status |= VL53L8CX_WaitUs(&(p_dev->platform), interval_us);
+		if(interval_us < VL53L8CX_POLL_MAX_INTERVAL_US)
 		{
-			timeout++;
+			interval_us *= (uint32_t)2;
+			if(interval_us > VL53L8CX_POLL_MAX_INTERVAL_US)
+			{
+				interval_us = VL53L8CX_POLL_MAX_INTERVAL_US;
+			}
 		}
-	}while ((p_dev->temp_buffer[pos] & mask) != expected_value);
+	}
 
+	VL53L8CX_StatsAdd(&(p_dev->platform), VL53L8CX_STATS_POLL, stats_us,
+		reads, status);
 	return status;
 }
 
@@ -63,10 +171,14 @@ static uint8_t _vl53l8cx_poll_for_mcu_boot(
               VL53L8CX_Configuration      *p_dev)
 {
    uint8_t go2_status0, go2_status1, status = VL53L8CX_STATUS_OK;
-   uint16_t timeout = 0;
+   uint32_t reads = 0;
+   uint64_t deadline_us, stats_us;
 
+   stats_us = VL53L8CX_StatsStart();
+   deadline_us = _vl53l8cx_wait_deadline(p_dev, VL53L8CX_MCU_BOOT_TIMEOUT_MS);
    do {
 		status |= VL53L8CX_RdByte(&(p_dev->platform), 0x06, &go2_status0);
+		reads++;
 		if((go2_status0 & (uint8_t)0x80) != (uint8_t)0){
 			status |= VL53L8CX_RdByte(&(p_dev->platform), 0x07, &go2_status1);
             if(go2_status1 & (uint8_t)0x01)
@@ -75,27 +187,32 @@ static uint8_t _vl53l8cx_poll_for_mcu_boot(
     			break;
             }
 		}
-		(void)VL53L8CX_WaitMs(&(p_dev->platform), 1);
-		timeout++;
-
 		if((go2_status0 & (uint8_t)0x1) != (uint8_t)0){
 			break;
 		}
-	}while (timeout < (uint16_t)500);
 
+		if(VL53L8CX_GetTimeUs(&(p_dev->platform)) >= deadline_us){
+			status |= VL53L8CX_STATUS_TIMEOUT_ERROR;
+			break;
+		}
+		(void)VL53L8CX_WaitMs(&(p_dev->platform), 1);
+	}while (1);
+
+   VL53L8CX_StatsAdd(&(p_dev->platform), VL53L8CX_STATS_POLL, stats_us,
+		reads, status);
    return status;
 }
 
 /**
  * @brief Inner function, not available outside this file. This function is used
- * to set the offset data gathered from NVM.
+ * to format the offset data gathered from NVM for the required resolution.
  */
 
-static uint8_t _vl53l8cx_send_offset_data(
+static void _vl53l8cx_build_offset_data(
 		VL53L8CX_Configuration		*p_dev,
-		uint8_t						resolution)
+		uint8_t						resolution,
+		uint8_t						*buffer)
 {
-	uint8_t status = VL53L8CX_STATUS_OK;
 	uint32_t signal_grid[64];
 	int16_t range_grid[64];
 	uint8_t dss_4x4[] = {0x0F, 0x04, 0x04, 0x00, 0x08, 0x10, 0x10, 0x07};
@@ -103,16 +220,16 @@ static uint8_t _vl53l8cx_send_offset_data(
 	int8_t i, j;
 	uint16_t k;
 
-	(void)memcpy(p_dev->temp_buffer,
+	(void)memcpy(buffer,
                p_dev->offset_data, VL53L8CX_OFFSET_BUFFER_SIZE);
 
 	/* Data extrapolation is required for 4X4 offset */
 	if(resolution == (uint8_t)VL53L8CX_RESOLUTION_4X4){
-		(void)memcpy(&(p_dev->temp_buffer[0x10]), dss_4x4, sizeof(dss_4x4));
-		VL53L8CX_SwapBuffer(p_dev->temp_buffer, VL53L8CX_OFFSET_BUFFER_SIZE);
-		(void)memcpy(signal_grid,&(p_dev->temp_buffer[0x3C]),
+		(void)memcpy(&(buffer[0x10]), dss_4x4, sizeof(dss_4x4));
+		VL53L8CX_SwapBuffer(buffer, VL53L8CX_OFFSET_BUFFER_SIZE);
+		(void)memcpy(signal_grid,&(buffer[0x3C]),
 			sizeof(signal_grid));
-		(void)memcpy(range_grid,&(p_dev->temp_buffer[0x140]),
+		(void)memcpy(range_grid,&(buffer[0x140]),
 			sizeof(range_grid));
 
 		for (j = 0; j < (int8_t)4; j++)
@@ -135,20 +252,36 @@ static uint8_t _vl53l8cx_send_offset_data(
 		}
 	    (void)memset(&range_grid[0x10], 0, (uint16_t)96);
 	    (void)memset(&signal_grid[0x10], 0, (uint16_t)192);
-            (void)memcpy(&(p_dev->temp_buffer[0x3C]),
+            (void)memcpy(&(buffer[0x3C]),
 		signal_grid, sizeof(signal_grid));
-            (void)memcpy(&(p_dev->temp_buffer[0x140]),
+            (void)memcpy(&(buffer[0x140]),
 		range_grid, sizeof(range_grid));
-            VL53L8CX_SwapBuffer(p_dev->temp_buffer, VL53L8CX_OFFSET_BUFFER_SIZE);
+            VL53L8CX_SwapBuffer(buffer, VL53L8CX_OFFSET_BUFFER_SIZE);
 	}
 
-	for(k = 0; k < (VL53L8CX_OFFSET_BUFFER_SIZE - (uint16_t)4); k++)
+	/* Drop the 8 bytes header, the footer takes the last 8 bytes */
+	for(k = 0; k < (VL53L8CX_OFFSET_BUFFER_SIZE - (uint16_t)8); k++)
 	{
-		p_dev->temp_buffer[k] = p_dev->temp_buffer[k + (uint16_t)8];
+		buffer[k] = buffer[k + (uint16_t)8];
 	}
 
-	(void)memcpy(&(p_dev->temp_buffer[0x1E0]), footer, 8);
-	status |= VL53L8CX_WrMulti(&(p_dev->platform), 0x2e18, p_dev->temp_buffer,
+	(void)memcpy(&(buffer[0x1E0]), footer, 8);
+}
+
+/**
+ * @brief Inner function, not available outside this file. This function is used
+ * to set the offset data gathered from NVM.
+ */
+
+static uint8_t _vl53l8cx_send_offset_data(
+		VL53L8CX_Configuration		*p_dev,
+		uint8_t						resolution)
+{
+	uint8_t status = VL53L8CX_STATUS_OK;
+	uint8_t *buffer = (resolution == (uint8_t)VL53L8CX_RESOLUTION_4X4)
+		? p_dev->offset_upload_4x4 : p_dev->offset_upload_8x8;
+
+	status |= VL53L8CX_WrMulti(&(p_dev->platform), 0x2e18, buffer,
 		VL53L8CX_OFFSET_BUFFER_SIZE);
 	status |=_vl53l8cx_poll_for_answer(p_dev, 4, 1,
 		VL53L8CX_UI_CMD_STATUS, 0xff, 0x03);
@@ -158,33 +291,33 @@ static uint8_t _vl53l8cx_send_offset_data(
 
 /**
  * @brief Inner function, not available outside this file. This function is used
- * to set the Xtalk data from generic configuration, or user's calibration.
+ * to format the Xtalk data for the required resolution.
  */
 
-static uint8_t _vl53l8cx_send_xtalk_data(
+static void _vl53l8cx_build_xtalk_data(
 		VL53L8CX_Configuration		*p_dev,
-		uint8_t				resolution)
+		uint8_t				resolution,
+		uint8_t				*buffer)
 {
-	uint8_t status = VL53L8CX_STATUS_OK;
 	uint8_t res4x4[] = {0x0F, 0x04, 0x04, 0x17, 0x08, 0x10, 0x10, 0x07};
 	uint8_t dss_4x4[] = {0x00, 0x78, 0x00, 0x08, 0x00, 0x00, 0x00, 0x08};
 	uint8_t profile_4x4[] = {0xA0, 0xFC, 0x01, 0x00};
 	uint32_t signal_grid[64];
 	int8_t i, j;
 
-	(void)memcpy(p_dev->temp_buffer, &(p_dev->xtalk_data[0]),
+	(void)memcpy(buffer, &(p_dev->xtalk_data[0]),
 		VL53L8CX_XTALK_BUFFER_SIZE);
 
 	/* Data extrapolation is required for 4X4 Xtalk */
 	if(resolution == (uint8_t)VL53L8CX_RESOLUTION_4X4)
 	{
-		(void)memcpy(&(p_dev->temp_buffer[0x8]),
+		(void)memcpy(&(buffer[0x8]),
 			res4x4, sizeof(res4x4));
-		(void)memcpy(&(p_dev->temp_buffer[0x020]),
+		(void)memcpy(&(buffer[0x020]),
 			dss_4x4, sizeof(dss_4x4));
 
-		VL53L8CX_SwapBuffer(p_dev->temp_buffer, VL53L8CX_XTALK_BUFFER_SIZE);
-		(void)memcpy(signal_grid, &(p_dev->temp_buffer[0x34]),
+		VL53L8CX_SwapBuffer(buffer, VL53L8CX_XTALK_BUFFER_SIZE);
+		(void)memcpy(signal_grid, &(buffer[0x34]),
 			sizeof(signal_grid));
 
 		for (j = 0; j < (int8_t)4; j++)
@@ -199,23 +332,55 @@ static uint8_t _vl53l8cx_send_xtalk_data(
 			}
 		}
 	    (void)memset(&signal_grid[0x10], 0, (uint32_t)192);
-	    (void)memcpy(&(p_dev->temp_buffer[0x34]),
+	    (void)memcpy(&(buffer[0x34]),
                   signal_grid, sizeof(signal_grid));
-	    VL53L8CX_SwapBuffer(p_dev->temp_buffer, VL53L8CX_XTALK_BUFFER_SIZE);
-	    (void)memcpy(&(p_dev->temp_buffer[0x134]),
+	    VL53L8CX_SwapBuffer(buffer, VL53L8CX_XTALK_BUFFER_SIZE);
+	    (void)memcpy(&(buffer[0x134]),
 	    profile_4x4, sizeof(profile_4x4));
-	    (void)memset(&(p_dev->temp_buffer[0x078]),0 ,
+	    (void)memset(&(buffer[0x078]),0 ,
                          (uint32_t)4*sizeof(uint8_t));
 	}
+}
+
+/**
+ * @brief Inner function, not available outside this file. This function is used
+ * to set the Xtalk data from generic configuration, or user's calibration.
+ */
+
+static uint8_t _vl53l8cx_send_xtalk_data(
+		VL53L8CX_Configuration		*p_dev,
+		uint8_t				resolution)
+{
+	uint8_t status = VL53L8CX_STATUS_OK;
+	uint8_t *buffer = (resolution == (uint8_t)VL53L8CX_RESOLUTION_4X4)
+		? p_dev->xtalk_upload_4x4 : p_dev->xtalk_upload_8x8;
 
 	status |= VL53L8CX_WrMulti(&(p_dev->platform), 0x2cf8,
-			p_dev->temp_buffer, VL53L8CX_XTALK_BUFFER_SIZE);
+			buffer, VL53L8CX_XTALK_BUFFER_SIZE);
 	status |=_vl53l8cx_poll_for_answer(p_dev, 4, 1,
 			VL53L8CX_UI_CMD_STATUS, 0xff, 0x03);
 
 	return status;
 }
 
+void vl53l8cx_prepare_offset_data(
+		VL53L8CX_Configuration		*p_dev)
+{
+	_vl53l8cx_build_offset_data(p_dev, VL53L8CX_RESOLUTION_4X4,
+		p_dev->offset_upload_4x4);
+	_vl53l8cx_build_offset_data(p_dev, VL53L8CX_RESOLUTION_8X8,
+		p_dev->offset_upload_8x8);
+}
+
+void vl53l8cx_prepare_xtalk_data(
+		VL53L8CX_Configuration		*p_dev)
+{
+	_vl53l8cx_build_xtalk_data(p_dev, VL53L8CX_RESOLUTION_4X4,
+		p_dev->xtalk_upload_4x4);
+	_vl53l8cx_build_xtalk_data(p_dev, VL53L8CX_RESOLUTION_8X8,
+		p_dev->xtalk_upload_8x8);
+}
+
 uint8_t vl53l8cx_is_alive(
 		VL53L8CX_Configuration		*p_dev,
 		uint8_t				*p_is_alive)
@@ -240,20 +405,20 @@ uint8_t vl53l8cx_is_alive(
 	return status;
 }
 
-uint8_t vl53l8cx_init(
+/**
+ * @brief Inner function, not available outside this file. This function is used
+ * to reboot the sensor and to download the firmware.
+ */
+
+static uint8_t _vl53l8cx_load_firmware(
 		VL53L8CX_Configuration		*p_dev)
 {
 	uint8_t tmp, status = VL53L8CX_STATUS_OK;
-	uint8_t pipe_ctrl[] = {VL53L8CX_NB_TARGET_PER_ZONE, 0x00, 0x01, 0x00};
-	uint32_t single_range = 0x01;
 	uint32_t crc_checksum = 0x00;
 
-	p_dev->default_xtalk = (uint8_t*)VL53L8CX_DEFAULT_XTALK;
-	p_dev->default_configuration = (uint8_t*)VL53L8CX_DEFAULT_CONFIGURATION;
-	p_dev->is_auto_stop_enabled = (uint8_t)0x0;
-	p_dev->crc_checksum_for_results_pkt = (uint8_t)0x0;
-
 	/* SW reboot sequence */
+	VL53L8CX_InvalidatePage(&(p_dev->platform));
+	status |= VL53L8CX_BeginTransaction(&(p_dev->platform));
 	status |= VL53L8CX_WrByte(&(p_dev->platform), 0x7fff, 0x00);
 	status |= VL53L8CX_WrByte(&(p_dev->platform), 0x0009, 0x04);
 	status |= VL53L8CX_WrByte(&(p_dev->platform), 0x000F, 0x40);
@@ -270,11 +435,15 @@ uint8_t vl53l8cx_init(
 	status |= VL53L8CX_WrByte(&(p_dev->platform), 0x0103, 0x01);
 	status |= VL53L8CX_WrByte(&(p_dev->platform), 0x000C, 0x00);
 	status |= VL53L8CX_WrByte(&(p_dev->platform), 0x000F, 0x43);
+	status |= VL53L8CX_CommitTransaction(&(p_dev->platform));
 	status |= VL53L8CX_WaitMs(&(p_dev->platform), 1);
 
+	status |= VL53L8CX_BeginTransaction(&(p_dev->platform));
 	status |= VL53L8CX_WrByte(&(p_dev->platform), 0x000F, 0x40);
 	status |= VL53L8CX_WrByte(&(p_dev->platform), 0x000A, 0x01);
+	status |= VL53L8CX_CommitTransaction(&(p_dev->platform));
 	status |= VL53L8CX_WaitMs(&(p_dev->platform), 100);
+	VL53L8CX_InvalidatePage(&(p_dev->platform));
 
 	/* Wait for sensor booted (several ms required to get sensor ready ) */
 	status |= VL53L8CX_WrByte(&(p_dev->platform), 0x7fff, 0x00);
@@ -283,14 +452,18 @@ uint8_t vl53l8cx_init(
 		goto exit;
 	}
 
+	status |= VL53L8CX_BeginTransaction(&(p_dev->platform));
 	status |= VL53L8CX_WrByte(&(p_dev->platform), 0x000E, 0x01);
 	status |= VL53L8CX_WrByte(&(p_dev->platform), 0x7fff, 0x02);
 
 	/* Enable FW access */
 	status |= VL53L8CX_WrByte(&(p_dev->platform), 0x7fff, 0x01);
 	status |= VL53L8CX_WrByte(&(p_dev->platform), 0x06, 0x01);
+	status |= VL53L8CX_CommitTransaction(&(p_dev->platform));
 	status |= _vl53l8cx_poll_for_answer(p_dev, 1, 0, 0x21, 0xFF, 0x4);
 
+	/* Power on and FW download, up to the FW check, in one transaction */
+	status |= VL53L8CX_BeginTransaction(&(p_dev->platform));
 	status |= VL53L8CX_WrByte(&(p_dev->platform), 0x7fff, 0x00);
 
 	/* Enable host access to GO1 */
@@ -334,8 +507,10 @@ uint8_t vl53l8cx_init(
 	/* Check if FW correctly downloaded */
 	status |= VL53L8CX_WrByte(&(p_dev->platform), 0x7fff, 0x01);
 	status |= VL53L8CX_WrByte(&(p_dev->platform), 0x06, 0x03);
+	status |= VL53L8CX_CommitTransaction(&(p_dev->platform));
 
 	status |= VL53L8CX_WaitMs(&(p_dev->platform), 5);
+	status |= VL53L8CX_BeginTransaction(&(p_dev->platform));
 	status |= VL53L8CX_WrByte(&(p_dev->platform), 0x7fff, 0x00);
 	status |= VL53L8CX_RdByte(&(p_dev->platform), 0x7fff, &tmp);
 	status |= VL53L8CX_WrByte(&(p_dev->platform), 0x0C, 0x01);
@@ -350,6 +525,8 @@ uint8_t vl53l8cx_init(
 	status |= VL53L8CX_RdByte(&(p_dev->platform), 0x7fff, &tmp);
 	status |= VL53L8CX_WrByte(&(p_dev->platform), 0x0C, 0x00);
 	status |= VL53L8CX_WrByte(&(p_dev->platform), 0x0B, 0x01);
+	status |= VL53L8CX_CommitTransaction(&(p_dev->platform));
+	VL53L8CX_InvalidatePage(&(p_dev->platform));
 
 	status |= _vl53l8cx_poll_for_mcu_boot(p_dev);
 	if(status != (uint8_t)0){
@@ -369,20 +546,24 @@ uint8_t vl53l8cx_init(
 		goto exit;
 	}
 
-	/* Get offset NVM data and store them into the offset buffer */
-	status |= VL53L8CX_WrMulti(&(p_dev->platform), 0x2fd8,
-		(uint8_t*)VL53L8CX_GET_NVM_CMD, sizeof(VL53L8CX_GET_NVM_CMD));
-	status |= _vl53l8cx_poll_for_answer(p_dev, 4, 0,
-		VL53L8CX_UI_CMD_STATUS, 0xff, 2);
-	status |= VL53L8CX_RdMulti(&(p_dev->platform), VL53L8CX_UI_CMD_START,
-		p_dev->temp_buffer, VL53L8CX_NVM_DATA_SIZE);
-	(void)memcpy(p_dev->offset_data, p_dev->temp_buffer,
-		VL53L8CX_OFFSET_BUFFER_SIZE);
-	status |= _vl53l8cx_send_offset_data(p_dev, VL53L8CX_RESOLUTION_4X4);
+exit:
+	return status;
+}
 
-	/* Set default Xtalk shape. Send Xtalk to sensor */
-	(void)memcpy(p_dev->xtalk_data, (uint8_t*)VL53L8CX_DEFAULT_XTALK,
-		VL53L8CX_XTALK_BUFFER_SIZE);
+/**
+ * @brief Inner function, not available outside this file. This function is used
+ * to send the calibration data and the default configuration, in 4x4.
+ */
+
+static uint8_t _vl53l8cx_send_default_configuration(
+		VL53L8CX_Configuration		*p_dev)
+{
+	uint8_t status = VL53L8CX_STATUS_OK;
+	uint8_t pipe_ctrl[] = {p_dev->nb_target_per_zone, 0x00, 0x01, 0x00};
+	uint32_t single_range = 0x01;
+	uint8_t tmp;
+
+	status |= _vl53l8cx_send_offset_data(p_dev, VL53L8CX_RESOLUTION_4X4);
 	status |= _vl53l8cx_send_xtalk_data(p_dev, VL53L8CX_RESOLUTION_4X4);
 
 	/* Send default configuration to VL53L8CX firmware */
@@ -391,20 +572,189 @@ uint8_t vl53l8cx_init(
 		sizeof(VL53L8CX_DEFAULT_CONFIGURATION));
 	status |= _vl53l8cx_poll_for_answer(p_dev, 4, 1,
 		VL53L8CX_UI_CMD_STATUS, 0xff, 0x03);
+	vl53l8cx_dci_invalidate_shadow(p_dev);
 
 	status |= vl53l8cx_dci_write_data(p_dev, (uint8_t*)&pipe_ctrl,
 		VL53L8CX_DCI_PIPE_CONTROL, (uint16_t)sizeof(pipe_ctrl));
-#if VL53L8CX_NB_TARGET_PER_ZONE != 1
-	tmp = VL53L8CX_NB_TARGET_PER_ZONE;
-	status |= vl53l8cx_dci_replace_data(p_dev, p_dev->temp_buffer,
-		VL53L8CX_DCI_FW_NB_TARGET, 16,
-	(uint8_t*)&tmp, 1, 0x0C);
-#endif
+	/* The firmware uses 2 targets per zone for 1 target per zone, which
+	 * is also the value of the default configuration */
+	tmp = (p_dev->nb_target_per_zone == (uint8_t)1)
+		? (uint8_t)2 : p_dev->nb_target_per_zone;
+	if ((p_dev->nb_target_per_zone != (uint8_t)1)
+		|| (tmp != (uint8_t)VL53L8CX_FW_NBTAR_RANGING))
+	{
+		status |= vl53l8cx_dci_replace_data(p_dev, p_dev->temp_buffer,
+			VL53L8CX_DCI_FW_NB_TARGET, 16,
+		(uint8_t*)&tmp, 1, 0x0C);
+	}
 
 	status |= vl53l8cx_dci_write_data(p_dev, (uint8_t*)&single_range,
 			VL53L8CX_DCI_SINGLE_RANGE,
 			(uint16_t)sizeof(single_range));
 
+	return status;
+}
+
+/**
+ * @brief Inner function, not available outside this file. This function is used
+ * to wake up the sensor from deep sleep. If the firmware is still running with
+ * the last configuration nothing is sent. Otherwise the firmware is downloaded
+ * again and the host state (offset, Xtalk and configuration blocks) is
+ * restored, without reading the NVM.
+ */
+
+static uint8_t _vl53l8cx_resume_from_deep_sleep(
+		VL53L8CX_Configuration		*p_dev)
+{
+	uint8_t go2_status0 = 0, go2_status1 = 0, status = VL53L8CX_STATUS_OK;
+	uint8_t i, block_status, pipe_ctrl[4];
+	uint8_t shadow[VL53L8CX_DCI_SHADOW_SIZE];
+	uint16_t offset = 0, shadow_valid, bit, pipe_offset = 0;
+	int8_t pipe_block, zone_block;
+	uint64_t deadline_us = p_dev->deadline_us;
+
+	/* Save the host copy of the configuration */
+	(void)memcpy(shadow, p_dev->dci_shadow, sizeof(shadow));
+	shadow_valid = p_dev->dci_shadow_valid;
+
+	/* Cheap check: the MCU is booted and the FW still answers with the
+	 * pipe control block written by vl53l8cx_init() */
+	status |= VL53L8CX_BeginTransaction(&(p_dev->platform));
+	status |= VL53L8CX_WrByte(&(p_dev->platform), 0x7fff, 0x00);
+	status |= VL53L8CX_RdByte(&(p_dev->platform), 0x06, &go2_status0);
+	status |= VL53L8CX_RdByte(&(p_dev->platform), 0x07, &go2_status1);
+	status |= VL53L8CX_WrByte(&(p_dev->platform), 0x7fff, 0x02);
+	status |= VL53L8CX_CommitTransaction(&(p_dev->platform));
+
+	pipe_block = _vl53l8cx_dci_shadow_find(VL53L8CX_DCI_PIPE_CONTROL,
+			(uint16_t)sizeof(pipe_ctrl), &pipe_offset);
+	if((status == VL53L8CX_STATUS_OK)
+		&& ((go2_status0 & (uint8_t)0x80) != (uint8_t)0)
+		&& ((go2_status1 & (uint8_t)0x01) != (uint8_t)0)
+		&& ((shadow_valid & ((uint16_t)1 << pipe_block)) != (uint16_t)0))
+	{
+		/* The answer of the last command is cleared, so that only the
+		 * FW can report the read as done. A FW that does not answer
+		 * quickly is reloaded, instead of waiting
+		 * VL53L8CX_POLL_TIMEOUT_MS */
+		p_dev->dci_shadow_valid &= ~((uint16_t)1 << pipe_block);
+		(void)memset(pipe_ctrl, 0, sizeof(pipe_ctrl));
+		block_status = VL53L8CX_WrMulti(&(p_dev->platform),
+				VL53L8CX_UI_CMD_STATUS, pipe_ctrl,
+				(uint32_t)sizeof(pipe_ctrl));
+		p_dev->deadline_us = _vl53l8cx_wait_deadline(p_dev,
+				VL53L8CX_RESUME_CHECK_TIMEOUT_MS);
+		block_status |= vl53l8cx_dci_read_data(p_dev, pipe_ctrl,
+				VL53L8CX_DCI_PIPE_CONTROL, (uint16_t)sizeof(pipe_ctrl));
+		p_dev->deadline_us = deadline_us;
+		if((block_status == VL53L8CX_STATUS_OK)
+			&& (memcmp(pipe_ctrl, &(shadow[pipe_offset]),
+				sizeof(pipe_ctrl)) == 0))
+		{
+			return VL53L8CX_STATUS_OK;
+		}
+	}
+
+	/* FW lost: download it again and restore the host state */
+	status = VL53L8CX_STATUS_OK;
+	p_dev->is_auto_stop_enabled = (uint8_t)0x0;
+	p_dev->config_staging = (uint8_t)0;
+	p_dev->config_caldata_pending = (uint8_t)0;
+	vl53l8cx_dci_invalidate_shadow(p_dev);
+
+	status |= _vl53l8cx_load_firmware(p_dev);
+	if(status != (uint8_t)0){
+		goto exit;
+	}
+	status |= _vl53l8cx_send_default_configuration(p_dev);
+
+	/* Only send the blocks which differ from the default configuration */
+	status |= vl53l8cx_begin_config(p_dev);
+	for(i = 0; i < VL53L8CX_DCI_SHADOW_NB_BLOCKS; i++)
+	{
+		bit = (uint16_t)1 << i;
+		if(((shadow_valid & bit) != (uint16_t)0)
+			&& (((p_dev->dci_shadow_valid & bit) == (uint16_t)0)
+			|| (memcmp(&(p_dev->dci_shadow[offset]), &(shadow[offset]),
+				_vl53l8cx_dci_shadow_size[i]) != 0)))
+		{
+			(void)memcpy(&(p_dev->dci_shadow[offset]), &(shadow[offset]),
+				_vl53l8cx_dci_shadow_size[i]);
+			p_dev->dci_shadow_valid |= bit;
+			p_dev->dci_shadow_dirty |= bit;
+		}
+		offset += _vl53l8cx_dci_shadow_size[i];
+	}
+
+	/* Offset and Xtalk were sent for 4x4 */
+	zone_block = _vl53l8cx_dci_shadow_find(VL53L8CX_DCI_ZONE_CONFIG, 8,
+			&offset);
+	if((p_dev->dci_shadow_dirty & ((uint16_t)1 << zone_block)) != (uint16_t)0)
+	{
+		p_dev->config_caldata_pending = (uint8_t)1;
+	}
+	status |= vl53l8cx_commit_config(p_dev);
+
+	if(p_dev->crc_checksum_for_results_pkt != (uint8_t)0)
+	{
+		status |= vl53l8cx_set_results_crc(p_dev,
+				VL53L8CX_CRC_RESULTS_PKT_ON);
+	}
+
+exit:
+	return status;
+}
+
+uint8_t vl53l8cx_init(
+		VL53L8CX_Configuration		*p_dev)
+{
+	uint8_t status = VL53L8CX_STATUS_OK;
+
+	p_dev->default_xtalk = (uint8_t*)VL53L8CX_DEFAULT_XTALK;
+	p_dev->default_configuration = (uint8_t*)VL53L8CX_DEFAULT_CONFIGURATION;
+	p_dev->is_auto_stop_enabled = (uint8_t)0x0;
+	p_dev->crc_checksum_for_results_pkt = (uint8_t)0x0;
+	p_dev->outputs = VL53L8CX_OUTPUTS_AVAILABLE;
+	p_dev->nb_target_per_zone = (uint8_t)VL53L8CX_NB_TARGET_PER_ZONE;
+#ifdef VL53L8CX_USE_RAW_FORMAT
+	p_dev->is_raw_format = (uint8_t)1;
+#else
+	p_dev->is_raw_format = (uint8_t)0;
+#endif
+	p_dev->last_answer_time_us = (uint32_t)0;
+	p_dev->max_answer_time_us = (uint32_t)0;
+	p_dev->config_staging = (uint8_t)0;
+	p_dev->config_caldata_pending = (uint8_t)0;
+	p_dev->is_calibration_loaded = (uint8_t)0;
+	p_dev->layout_nb_blocks = (uint8_t)0;
+	p_dev->view.is_valid = (uint8_t)0;
+	vl53l8cx_dci_invalidate_shadow(p_dev);
+
+	status |= _vl53l8cx_load_firmware(p_dev);
+	if(status != (uint8_t)0){
+		goto exit;
+	}
+
+	/* Get offset NVM data and store them into the offset buffer */
+	status |= VL53L8CX_WrMulti(&(p_dev->platform), 0x2fd8,
+		(uint8_t*)VL53L8CX_GET_NVM_CMD, sizeof(VL53L8CX_GET_NVM_CMD));
+	status |= _vl53l8cx_poll_for_answer(p_dev, 4, 0,
+		VL53L8CX_UI_CMD_STATUS, 0xff, 2);
+	status |= VL53L8CX_RdMulti(&(p_dev->platform), VL53L8CX_UI_CMD_START,
+		p_dev->temp_buffer, VL53L8CX_NVM_DATA_SIZE);
+	(void)memcpy(p_dev->offset_data, p_dev->temp_buffer,
+		VL53L8CX_OFFSET_BUFFER_SIZE);
+	vl53l8cx_prepare_offset_data(p_dev);
+
+	/* Set default Xtalk shape */
+	(void)memcpy(p_dev->xtalk_data, (uint8_t*)VL53L8CX_DEFAULT_XTALK,
+		VL53L8CX_XTALK_BUFFER_SIZE);
+	vl53l8cx_prepare_xtalk_data(p_dev);
+	p_dev->is_calibration_loaded = (uint8_t)(status == VL53L8CX_STATUS_OK);
+
+	/* Send offset, Xtalk and default configuration to VL53L8CX firmware */
+	status |= _vl53l8cx_send_default_configuration(p_dev);
+
 exit:
 	return status;
 }
@@ -429,8 +779,10 @@ uint8_t vl53l8cx_get_power_mode(
 {
 	uint8_t tmp, status = VL53L8CX_STATUS_OK;
 
+	status |= VL53L8CX_BeginTransaction(&(p_dev->platform));
 	status |= VL53L8CX_WrByte(&(p_dev->platform), 0x7FFF, 0x00);
 	status |= VL53L8CX_RdByte(&(p_dev->platform), 0x009, &tmp);
+	status |= VL53L8CX_CommitTransaction(&(p_dev->platform));
 
 	switch(tmp)
 	{
@@ -472,9 +824,11 @@ uint8_t vl53l8cx_set_power_mode(
 	switch(power_mode)
 	{
 		case VL53L8CX_POWER_MODE_WAKEUP:
+			status |= VL53L8CX_BeginTransaction(&(p_dev->platform));
 			status |= VL53L8CX_WrByte(&(p_dev->platform), 0x7FFF, 0x00);
 			status |= VL53L8CX_WrByte(&(p_dev->platform), 0x09, 0x04);
 			status |= VL53L8CX_RdByte(&(p_dev->platform), 0x000F, &stored_mode);
+			status |= VL53L8CX_CommitTransaction(&(p_dev->platform));
 			if(stored_mode == 0x43) /* Only for deep sleep mode */
 			{
 				status |= VL53L8CX_WrByte(&(p_dev->platform), 0x000F, 0x40);
@@ -483,22 +837,35 @@ uint8_t vl53l8cx_set_power_mode(
 						p_dev, 1, 0, 0x06, 0x01, 1);
 			if(stored_mode == 0x43) /* Only for deep sleep mode */
 			{
-				status |= vl53l8cx_init(p_dev);
+				if(p_dev->is_calibration_loaded != (uint8_t)0)
+				{
+					status |= _vl53l8cx_resume_from_deep_sleep(p_dev);
+				}
+				else
+				{
+					status |= vl53l8cx_init(p_dev);
+				}
 			}
 			break;
 
 		case VL53L8CX_POWER_MODE_SLEEP:
+			status |= VL53L8CX_BeginTransaction(&(p_dev->platform));
 			status |= VL53L8CX_WrByte(&(p_dev->platform), 0x7FFF, 0x00);
 			status |= VL53L8CX_WrByte(&(p_dev->platform), 0x09, 0x02);
+			status |= VL53L8CX_CommitTransaction(&(p_dev->platform));
 			status |= _vl53l8cx_poll_for_answer(
 						p_dev, 1, 0, 0x06, 0x01, 0);
 			break;
 
 		case VL53L8CX_POWER_MODE_DEEP_SLEEP:
+			status |= VL53L8CX_BeginTransaction(&(p_dev->platform));
 			status |= VL53L8CX_WrByte(&(p_dev->platform), 0x7FFF, 0x00);
 			status |= VL53L8CX_WrByte(&(p_dev->platform), 0x09, 0x02);
+			status |= VL53L8CX_CommitTransaction(&(p_dev->platform));
 			status |= _vl53l8cx_poll_for_answer(
 					p_dev, 1, 0, 0x06, 0x01, 0);
+			/* The host copy of the DCI blocks is kept, it is
+			 * restored by the wake up if the FW is lost */
 			status |= VL53L8CX_WrByte(&(p_dev->platform), 0x000F, 0x43);
 			break;
 
@@ -515,9 +882,9 @@ uint8_t vl53l8cx_set_power_mode(
 uint8_t vl53l8cx_start_ranging(
 		VL53L8CX_Configuration		*p_dev)
 {
-	uint8_t resolution, status = VL53L8CX_STATUS_OK;
+	uint8_t resolution, frequency_hz = 0, status = VL53L8CX_STATUS_OK;
 	uint16_t tmp;
-	uint32_t i;
+	uint32_t i, block_start;
 	uint32_t header_config[2] = {0, 0};
 
 	union Block_header *bh_ptr;
@@ -525,8 +892,17 @@ uint8_t vl53l8cx_start_ranging(
 
 	status |= vl53l8cx_get_resolution(p_dev, &resolution);
 	p_dev->data_read_size = 0;
+	p_dev->layout_nb_blocks = 0;
 	p_dev->streamcount = 255;
 
+	/* Expected frame period, refined from the stream count while polling */
+	status |= vl53l8cx_get_ranging_frequency_hz(p_dev, &frequency_hz);
+	p_dev->frame_period_us = (frequency_hz != (uint8_t)0)
+		? ((uint32_t)1000000 / (uint32_t)frequency_hz) : (uint32_t)0;
+	p_dev->frame_jitter_us = 0;
+	p_dev->frame_ready_us = 0;
+	p_dev->frame_outliers = 0;
+
 	/* Enable mandatory output (meta and common data) */
 	uint32_t output_bh_enable[] = {
 		0x00000007U,
@@ -540,42 +916,28 @@ uint8_t vl53l8cx_start_ranging(
 		VL53L8CX_COMMONDATA_BH,
 		VL53L8CX_AMBIENT_RATE_BH,
 		VL53L8CX_SPAD_COUNT_BH,
-		VL53L8CX_NB_TARGET_DETECTED_BH,
-		VL53L8CX_SIGNAL_RATE_BH,
-		VL53L8CX_RANGE_SIGMA_MM_BH,
-		VL53L8CX_DISTANCE_BH,
-		VL53L8CX_REFLECTANCE_BH,
-		VL53L8CX_TARGET_STATUS_BH,
-		VL53L8CX_MOTION_DETECT_BH};
-
-	/* Enable selected outputs in the 'platform.h' file */
-#ifndef VL53L8CX_DISABLE_AMBIENT_PER_SPAD
-	output_bh_enable[0] += (uint32_t)8;
-#endif
-#ifndef VL53L8CX_DISABLE_NB_SPADS_ENABLED
-	output_bh_enable[0] += (uint32_t)16;
-#endif
-#ifndef VL53L8CX_DISABLE_NB_TARGET_DETECTED
-	output_bh_enable[0] += (uint32_t)32;
-#endif
-#ifndef VL53L8CX_DISABLE_SIGNAL_PER_SPAD
-	output_bh_enable[0] += (uint32_t)64;
-#endif
-#ifndef VL53L8CX_DISABLE_RANGE_SIGMA_MM
-	output_bh_enable[0] += (uint32_t)128;
-#endif
-#ifndef VL53L8CX_DISABLE_DISTANCE_MM
-	output_bh_enable[0] += (uint32_t)256;
-#endif
-#ifndef VL53L8CX_DISABLE_REFLECTANCE_PERCENT
-	output_bh_enable[0] += (uint32_t)512;
-#endif
-#ifndef VL53L8CX_DISABLE_TARGET_STATUS
-	output_bh_enable[0] += (uint32_t)1024;
-#endif
-#ifndef VL53L8CX_DISABLE_MOTION_INDICATOR
-	output_bh_enable[0] += (uint32_t)2048;
-#endif
+		VL53L8CX_NB_TARGET_DETECTED_BH_1T,
+		VL53L8CX_SIGNAL_RATE_BH_1T,
+		VL53L8CX_RANGE_SIGMA_MM_BH_1T,
+		VL53L8CX_DISTANCE_BH_1T,
+		VL53L8CX_REFLECTANCE_BH_1T,
+		VL53L8CX_TARGET_STATUS_BH_1T,
+		VL53L8CX_MOTION_DETECT_BH_1T};
+
+	/* Per target results are elsewhere with more than 1 target per zone */
+	if (p_dev->nb_target_per_zone != (uint8_t)1)
+	{
+		output[5] = VL53L8CX_NB_TARGET_DETECTED_BH_NT;
+		output[6] = VL53L8CX_SIGNAL_RATE_BH_NT;
+		output[7] = VL53L8CX_RANGE_SIGMA_MM_BH_NT;
+		output[8] = VL53L8CX_DISTANCE_BH_NT;
+		output[9] = VL53L8CX_REFLECTANCE_BH_NT;
+		output[10] = VL53L8CX_TARGET_STATUS_BH_NT;
+		output[11] = VL53L8CX_MOTION_DETECT_BH_NT;
+	}
+
+	/* Enable the outputs selected by vl53l8cx_set_outputs() */
+	output_bh_enable[0] |= (uint32_t)p_dev->outputs;
 
 	/* Update data size */
 	for (i = 0; i < (uint32_t)(sizeof(output)/sizeof(uint32_t)); i++)
@@ -588,6 +950,7 @@ uint8_t vl53l8cx_start_ranging(
 		}
 
 		bh_ptr = (union Block_header *)&(output[i]);
+		block_start = p_dev->data_read_size;
 		if (((uint8_t)bh_ptr->type >= (uint8_t)0x1) 
                     && ((uint8_t)bh_ptr->type < (uint8_t)0x0d))
 		{
@@ -599,7 +962,7 @@ uint8_t vl53l8cx_start_ranging(
 			else
 			{
 				bh_ptr->size = (uint16_t)((uint16_t)resolution
-                                  * (uint16_t)VL53L8CX_NB_TARGET_PER_ZONE);
+                                  * (uint16_t)p_dev->nb_target_per_zone);
 			}
 			p_dev->data_read_size += bh_ptr->type * bh_ptr->size;
 		}
@@ -607,6 +970,17 @@ uint8_t vl53l8cx_start_ranging(
 		{
 			p_dev->data_read_size += bh_ptr->size;
 		}
+
+		/* Blocks follow the start block, from position 16 */
+		if (i != (uint32_t)0)
+		{
+			p_dev->layout[p_dev->layout_nb_blocks].header = output[i];
+			p_dev->layout[p_dev->layout_nb_blocks].offset =
+				(uint16_t)(block_start + (uint32_t)16);
+			p_dev->layout[p_dev->layout_nb_blocks].size =
+				(uint16_t)(p_dev->data_read_size - block_start);
+			p_dev->layout_nb_blocks++;
+		}
 		p_dev->data_read_size += (uint32_t)4;
 	}
 	p_dev->data_read_size += (uint32_t)32;
@@ -627,6 +1001,7 @@ uint8_t vl53l8cx_start_ranging(
 			(uint16_t)sizeof(output_bh_enable));
 
 	/* Start xshut bypass (interrupt mode) */
+	status |= VL53L8CX_BeginTransaction(&(p_dev->platform));
 	status |= VL53L8CX_WrByte(&(p_dev->platform), 0x7fff, 0x00);
 	status |= VL53L8CX_WrByte(&(p_dev->platform), 0x09, 0x05);
 	status |= VL53L8CX_WrByte(&(p_dev->platform), 0x7fff, 0x02);
@@ -634,6 +1009,7 @@ uint8_t vl53l8cx_start_ranging(
 	/* Start ranging session */
 	status |= VL53L8CX_WrMulti(&(p_dev->platform), VL53L8CX_UI_CMD_END -
 			(uint16_t)(4 - 1), (uint8_t*)cmd, sizeof(cmd));
+	status |= VL53L8CX_CommitTransaction(&(p_dev->platform));
 	status |= _vl53l8cx_poll_for_answer(p_dev, 4, 1,
 			VL53L8CX_UI_CMD_STATUS, 0xff, 0x03);
 
@@ -661,7 +1037,7 @@ uint8_t vl53l8cx_stop_ranging(
 		VL53L8CX_Configuration		*p_dev)
 {
 	uint8_t tmp = 0, status = VL53L8CX_STATUS_OK;
-	uint16_t timeout = 0;
+	uint64_t deadline_us;
 	uint32_t auto_stop_flag = 0;
 
 	status |= VL53L8CX_RdMulti(&(p_dev->platform),
@@ -669,24 +1045,31 @@ uint8_t vl53l8cx_stop_ranging(
 	if((auto_stop_flag != (uint32_t)0x4FF)
 			&& (p_dev->is_auto_stop_enabled == (uint8_t)0))
 	{
+	        status |= VL53L8CX_BeginTransaction(&(p_dev->platform));
 	        status |= VL53L8CX_WrByte(&(p_dev->platform), 0x7fff, 0x00);
 
 	        /* Provoke MCU stop */
 	        status |= VL53L8CX_WrByte(&(p_dev->platform), 0x15, 0x16);
 	        status |= VL53L8CX_WrByte(&(p_dev->platform), 0x14, 0x01);
+	        status |= VL53L8CX_CommitTransaction(&(p_dev->platform));
 
 	        /* Poll for G02 status 0 MCU stop */
+	        deadline_us = _vl53l8cx_wait_deadline(p_dev,
+	        		VL53L8CX_MCU_STOP_TIMEOUT_MS);
 	        while(((tmp & (uint8_t)0x80) >> 7) == (uint8_t)0x00)
 	        {
 	        	status |= VL53L8CX_RdByte(&(p_dev->platform), 0x6, &tmp);
-	        	status |= VL53L8CX_WaitMs(&(p_dev->platform), 10);
-	        	timeout++;	/* Timeout reached after 5 seconds */
+	        	if(((tmp & (uint8_t)0x80) >> 7) != (uint8_t)0x00)
+	        	{
+	        		break;
+	        	}
 
-	        	if(timeout > (uint16_t)500)
+	        	if(VL53L8CX_GetTimeUs(&(p_dev->platform)) >= deadline_us)
 				{
-					status |= tmp;
+					status |= VL53L8CX_STATUS_TIMEOUT_ERROR;
 					break;
 				}
+	        	status |= VL53L8CX_WaitMs(&(p_dev->platform), 10);
         	}
         }
 
@@ -700,6 +1083,7 @@ uint8_t vl53l8cx_stop_ranging(
 	}
 
 	/* Undo MCU stop */
+	status |= VL53L8CX_BeginTransaction(&(p_dev->platform));
 	status |= VL53L8CX_WrByte(&(p_dev->platform), 0x7fff, 0x00);
 	status |= VL53L8CX_WrByte(&(p_dev->platform), 0x14, 0x00);
 	status |= VL53L8CX_WrByte(&(p_dev->platform), 0x15, 0x00);
@@ -707,6 +1091,7 @@ uint8_t vl53l8cx_stop_ranging(
 	/* Stop xshut bypass */
 	status |= VL53L8CX_WrByte(&(p_dev->platform), 0x09, 0x04);
 	status |= VL53L8CX_WrByte(&(p_dev->platform), 0x7fff, 0x02);
+	status |= VL53L8CX_CommitTransaction(&(p_dev->platform));
 
 	return status;
 }
@@ -716,6 +1101,7 @@ uint8_t vl53l8cx_check_data_ready(
 		uint8_t				*p_isReady)
 {
 	uint8_t status = VL53L8CX_STATUS_OK;
+	uint64_t stats_us = VL53L8CX_StatsStart();
 
 	status |= VL53L8CX_RdMulti(&(p_dev->platform), 0x0, p_dev->temp_buffer, 4);
 
@@ -739,161 +1125,720 @@ uint8_t vl53l8cx_check_data_ready(
 		*p_isReady = 0;
 	}
 
+	VL53L8CX_StatsAdd(&(p_dev->platform), VL53L8CX_STATS_DATA_READY, stats_us,
+		*p_isReady, status);
 	return status;
 }
 
-uint8_t vl53l8cx_get_ranging_data(
-		VL53L8CX_Configuration		*p_dev,
-		VL53L8CX_ResultsData		*p_results)
-{
-	uint8_t status = VL53L8CX_STATUS_OK;
-	uint16_t header_id, footer_id;
-	union Block_header *bh_ptr;
-	uint32_t i, j, msize;
-	status |= VL53L8CX_RdMulti(&(p_dev->platform), 0x0,
-			p_dev->temp_buffer, p_dev->data_read_size);
-	p_dev->streamcount = p_dev->temp_buffer[0];
-	VL53L8CX_SwapBuffer(p_dev->temp_buffer, (uint16_t)p_dev->data_read_size);
+/*
+ * Conversion of the firmware values into the user format: division by a power
+ * of 2 given by its shift, and by 65535 for the motion. None if the device
+ * keeps the firmware format (vl53l8cx_set_raw_format())
+ */
+#define VL53L8CX_RESULTS_SHIFT(p_dev, shift) \
+	(((p_dev)->is_raw_format != (uint8_t)0) ? (uint8_t)0 : (uint8_t)(shift))
+#define VL53L8CX_MOTION_DIVIDER(p_dev) \
+	(((p_dev)->is_raw_format != (uint8_t)0) ? (uint32_t)1 : (uint32_t)65535)
 
-	/* Start conversion at position 16 to avoid headers */
-	for (i = (uint32_t)16; i 
-             < (uint32_t)p_dev->data_read_size; i+=(uint32_t)4)
-	{
-		bh_ptr = (union Block_header *)&(p_dev->temp_buffer[i]);
-		if ((bh_ptr->type > (uint32_t)0x1) 
-                    && (bh_ptr->type < (uint32_t)0xd))
-		{
-			msize = bh_ptr->type * bh_ptr->size;
-		}
-		else
-		{
-			msize = bh_ptr->size;
-		}
+/*
+ * Outputs of a results frame, as indexes of VL53L8CX_ResultsView
+ */
+#define VL53L8CX_BLOCK_METADATA			((uint8_t)0U)
+#define VL53L8CX_BLOCK_AMBIENT_PER_SPAD		((uint8_t)1U)
+#define VL53L8CX_BLOCK_NB_TARGET_DETECTED	((uint8_t)2U)
+#define VL53L8CX_BLOCK_NB_SPADS_ENABLED		((uint8_t)3U)
+#define VL53L8CX_BLOCK_SIGNAL_PER_SPAD		((uint8_t)4U)
+#define VL53L8CX_BLOCK_RANGE_SIGMA_MM		((uint8_t)5U)
+#define VL53L8CX_BLOCK_DISTANCE_MM		((uint8_t)6U)
+#define VL53L8CX_BLOCK_REFLECTANCE		((uint8_t)7U)
+#define VL53L8CX_BLOCK_TARGET_STATUS		((uint8_t)8U)
+#define VL53L8CX_BLOCK_MOTION_INDICATOR		((uint8_t)9U)
 
-		switch(bh_ptr->idx){
-			case VL53L8CX_METADATA_IDX:
-				p_results->silicon_temp_degc =
-						(int8_t)p_dev->temp_buffer[i + (uint32_t)12];
-				break;
+/**
+ * @brief Inner function, not available outside this file. This function
+ * returns the output of a block from its index (header >> 16), with 1 or more
+ * targets per zone, or VL53L8CX_NB_VIEW_OUTPUTS for the other blocks.
+ */
 
-#ifndef VL53L8CX_DISABLE_AMBIENT_PER_SPAD
-			case VL53L8CX_AMBIENT_RATE_IDX:
-				(void)memcpy(p_results->ambient_per_spad,
-				&(p_dev->temp_buffer[i + (uint32_t)4]), msize);
-				break;
+static uint8_t _vl53l8cx_block_output(
+		uint32_t			idx)
+{
+	uint8_t output;
+
+	switch(idx){
+		case VL53L8CX_METADATA_IDX:
+			output = VL53L8CX_BLOCK_METADATA;
+			break;
+		case VL53L8CX_AMBIENT_RATE_IDX:
+			output = VL53L8CX_BLOCK_AMBIENT_PER_SPAD;
+			break;
+		case VL53L8CX_SPAD_COUNT_IDX:
+			output = VL53L8CX_BLOCK_NB_SPADS_ENABLED;
+			break;
+		case VL53L8CX_NB_TARGET_DETECTED_IDX_1T:
+		case VL53L8CX_NB_TARGET_DETECTED_IDX_NT:
+			output = VL53L8CX_BLOCK_NB_TARGET_DETECTED;
+			break;
+		case VL53L8CX_SIGNAL_RATE_IDX_1T:
+		case VL53L8CX_SIGNAL_RATE_IDX_NT:
+			output = VL53L8CX_BLOCK_SIGNAL_PER_SPAD;
+			break;
+		case VL53L8CX_RANGE_SIGMA_MM_IDX_1T:
+		case VL53L8CX_RANGE_SIGMA_MM_IDX_NT:
+			output = VL53L8CX_BLOCK_RANGE_SIGMA_MM;
+			break;
+		case VL53L8CX_DISTANCE_IDX_1T:
+		case VL53L8CX_DISTANCE_IDX_NT:
+			output = VL53L8CX_BLOCK_DISTANCE_MM;
+			break;
+		case VL53L8CX_REFLECTANCE_EST_PC_IDX_1T:
+		case VL53L8CX_REFLECTANCE_EST_PC_IDX_NT:
+			output = VL53L8CX_BLOCK_REFLECTANCE;
+			break;
+		case VL53L8CX_TARGET_STATUS_IDX_1T:
+		case VL53L8CX_TARGET_STATUS_IDX_NT:
+			output = VL53L8CX_BLOCK_TARGET_STATUS;
+			break;
+		case VL53L8CX_MOTION_DETEC_IDX_1T:
+		case VL53L8CX_MOTION_DETEC_IDX_NT:
+			output = VL53L8CX_BLOCK_MOTION_INDICATOR;
+			break;
+		default:
+			output = VL53L8CX_NB_VIEW_OUTPUTS;
+			break;
+	}
+
+	return output;
+}
+
+/*
+ * Word of the firmware byte order (big endian) into the host order, on a word
+ * loaded with memcpy()
+ */
+#if defined(__BYTE_ORDER__) && (__BYTE_ORDER__ == __ORDER_BIG_ENDIAN__)
+#define VL53L8CX_BE32_TO_HOST(word)	(word)
+#else
+#define VL53L8CX_BE32_TO_HOST(word)	(((word) >> 24) \
+	| (((word) >> 8) & (uint32_t)0xff00) \
+	| (((word) << 8) & (uint32_t)0xff0000) | ((word) << 24))
 #endif
-#ifndef VL53L8CX_DISABLE_NB_SPADS_ENABLED
-			case VL53L8CX_SPAD_COUNT_IDX:
-				(void)memcpy(p_results->nb_spads_enabled,
-				&(p_dev->temp_buffer[i + (uint32_t)4]), msize);
-				break;
+
+/**
+ * @brief Inner functions, not available outside this file. They read the
+ * results in the firmware byte order (big endian 32 bits words), as the
+ * results buffer swapped by VL53L8CX_SwapBuffer() on a little endian host:
+ * the 16 and 8 bits values of a block are packed from the least significant
+ * bits of each word. Each one converts its values while copying them, and
+ * returns the checksum terms of the whole words it read (see
+ * vl53l8cx_generate_crc_checksum()), the first one being at crc_index.
+ */
+
+static inline uint32_t _vl53l8cx_be32(
+		const uint8_t			*p_data)
+{
+	uint32_t word;
+
+	(void)memcpy(&word, p_data, 4);
+	return VL53L8CX_BE32_TO_HOST(word);
+}
+
+#if defined(VL53L8CX_SIMD_SSE2)
+/* 4 words of the firmware byte order into the host order: 16 bits halves of
+ * each word swapped, then the bytes of each half */
+#define VL53L8CX_LOAD_BE32X4(p_data, v) do { \
+	(v) = _mm_loadu_si128((const __m128i *)(const void *)(p_data)); \
+	(v) = _mm_shufflehi_epi16(_mm_shufflelo_epi16((v), 0xB1), 0xB1); \
+	(v) = _mm_or_si128(_mm_slli_epi16((v), 8), _mm_srli_epi16((v), 8)); \
+	} while(0)
+#elif defined(VL53L8CX_SIMD_NEON)
+#define VL53L8CX_LOAD_BE32X4(p_data, v) do { \
+	(v) = vrev32q_u8(vld1q_u8(p_data)); \
+	} while(0)
 #endif
-#ifndef VL53L8CX_DISABLE_NB_TARGET_DETECTED
-			case VL53L8CX_NB_TARGET_DETECTED_IDX:
-				(void)memcpy(p_results->nb_target_detected,
-				&(p_dev->temp_buffer[i + (uint32_t)4]), msize);
-				break;
+
+/*
+ * Checksum terms of vl53l8cx_generate_crc_checksum(), 4 words at a time: each
+ * lane adds its word index (32 bits sum) and XORs it into its accumulator.
+ * The lanes are XORed together at the end.
+ */
+#if defined(VL53L8CX_SIMD_SSE2)
+#define VL53L8CX_CRC_INIT(index, acc, indexes) do { \
+	(acc) = _mm_setzero_si128(); \
+	(indexes) = _mm_add_epi32(_mm_set1_epi32((int32_t)(index)), \
+		_mm_set_epi32(3, 2, 1, 0)); \
+	} while(0)
+#define VL53L8CX_CRC_ADD(v, acc, indexes) do { \
+	(acc) = _mm_xor_si128((acc), _mm_add_epi32((v), (indexes))); \
+	(indexes) = _mm_add_epi32((indexes), _mm_set1_epi32(4)); \
+	} while(0)
+
+static inline uint32_t _vl53l8cx_crc_fold(
+		__m128i				acc)
+{
+	acc = _mm_xor_si128(acc, _mm_shuffle_epi32(acc, 0x4E));
+	acc = _mm_xor_si128(acc, _mm_shuffle_epi32(acc, 0xB1));
+	return (uint32_t)_mm_cvtsi128_si32(acc);
+}
+#elif defined(VL53L8CX_SIMD_NEON)
+#define VL53L8CX_CRC_INIT(index, acc, indexes) do { \
+	static const uint32_t lanes[4] = {0, 1, 2, 3}; \
+	(acc) = vdupq_n_u32(0); \
+	(indexes) = vaddq_u32(vdupq_n_u32(index), vld1q_u32(lanes)); \
+	} while(0)
+#define VL53L8CX_CRC_ADD(v, acc, indexes) do { \
+	(acc) = veorq_u32((acc), \
+		vaddq_u32(vreinterpretq_u32_u8(v), (indexes))); \
+	(indexes) = vaddq_u32((indexes), vdupq_n_u32(4)); \
+	} while(0)
+
+static inline uint32_t _vl53l8cx_crc_fold(
+		uint32x4_t			acc)
+{
+	return vgetq_lane_u32(acc, 0) ^ vgetq_lane_u32(acc, 1)
+		^ vgetq_lane_u32(acc, 2) ^ vgetq_lane_u32(acc, 3);
+}
 #endif
-#ifndef VL53L8CX_DISABLE_SIGNAL_PER_SPAD
-			case VL53L8CX_SIGNAL_RATE_IDX:
-				(void)memcpy(p_results->signal_per_spad,
-				&(p_dev->temp_buffer[i + (uint32_t)4]), msize);
-				break;
+
+#if defined(VL53L8CX_SIMD_SSE2)
+#define VL53L8CX_CRC_DECLARE	__m128i acc, indexes
+#elif defined(VL53L8CX_SIMD_NEON)
+#define VL53L8CX_CRC_DECLARE	uint32x4_t acc, indexes
 #endif
-#ifndef VL53L8CX_DISABLE_RANGE_SIGMA_MM
-			case VL53L8CX_RANGE_SIGMA_MM_IDX:
-				(void)memcpy(p_results->range_sigma_mm,
-				&(p_dev->temp_buffer[i + (uint32_t)4]), msize);
-				break;
+
+/*
+ * Checksum terms computed by the decoding functions, only when
+ * VL53L8CX_FUSED_RESULTS_CRC is defined in the 'platform.h' file
+ */
+#ifdef VL53L8CX_FUSED_RESULTS_CRC
+#define VL53L8CX_DECODE_CRC_INIT(index, acc, indexes) \
+	VL53L8CX_CRC_INIT(index, acc, indexes)
+#define VL53L8CX_DECODE_CRC_ADD(v, acc, indexes) \
+	VL53L8CX_CRC_ADD(v, acc, indexes)
+#define VL53L8CX_DECODE_CRC_FOLD(checksum, acc, indexes) do { \
+	(checksum) = _vl53l8cx_crc_fold(acc); \
+	} while(0)
+#define VL53L8CX_DECODE_CRC_TERM(checksum, index, word) do { \
+	(checksum) ^= (index) + (word); \
+	} while(0)
+#else
+#define VL53L8CX_DECODE_CRC_INIT(index, acc, indexes) do { \
+	} while(0)
+#define VL53L8CX_DECODE_CRC_ADD(v, acc, indexes) do { \
+	} while(0)
+#define VL53L8CX_DECODE_CRC_FOLD(checksum, acc, indexes) do { \
+	(void)(acc); \
+	(void)(indexes); \
+	} while(0)
+#define VL53L8CX_DECODE_CRC_TERM(checksum, index, word) do { \
+	} while(0)
 #endif
-#ifndef VL53L8CX_DISABLE_DISTANCE_MM
-			case VL53L8CX_DISTANCE_IDX:
-				(void)memcpy(p_results->distance_mm,
-				&(p_dev->temp_buffer[i + (uint32_t)4]), msize);
-				break;
+
+static inline uint32_t _vl53l8cx_decode_u32(
+		uint32_t			*p_dst,
+		const uint8_t			*p_src,
+		uint32_t			nb,
+		uint8_t				shift,
+		uint32_t			crc_index)
+{
+	uint32_t i = 0, word, checksum = 0;
+#if defined(VL53L8CX_SIMD_SSE2)
+	__m128i v;
+	VL53L8CX_CRC_DECLARE;
+	const __m128i count = _mm_cvtsi32_si128((int32_t)shift);
+
+	VL53L8CX_DECODE_CRC_INIT(crc_index, acc, indexes);
+	for(; (i + (uint32_t)4) <= nb; i += (uint32_t)4)
+	{
+		VL53L8CX_LOAD_BE32X4(&p_src[i * (uint32_t)4], v);
+		VL53L8CX_DECODE_CRC_ADD(v, acc, indexes);
+		_mm_storeu_si128((__m128i *)(void *)&p_dst[i],
+			_mm_srl_epi32(v, count));
+	}
+	VL53L8CX_DECODE_CRC_FOLD(checksum, acc, indexes);
+#elif defined(VL53L8CX_SIMD_NEON)
+	uint8x16_t v;
+	VL53L8CX_CRC_DECLARE;
+	const int32x4_t count = vdupq_n_s32(-(int32_t)shift);
+
+	VL53L8CX_DECODE_CRC_INIT(crc_index, acc, indexes);
+	for(; (i + (uint32_t)4) <= nb; i += (uint32_t)4)
+	{
+		VL53L8CX_LOAD_BE32X4(&p_src[i * (uint32_t)4], v);
+		VL53L8CX_DECODE_CRC_ADD(v, acc, indexes);
+		vst1q_u32(&p_dst[i], vshlq_u32(vreinterpretq_u32_u8(v), count));
+	}
+	VL53L8CX_DECODE_CRC_FOLD(checksum, acc, indexes);
 #endif
-#ifndef VL53L8CX_DISABLE_REFLECTANCE_PERCENT
-			case VL53L8CX_REFLECTANCE_EST_PC_IDX:
-				(void)memcpy(p_results->reflectance,
-				&(p_dev->temp_buffer[i + (uint32_t)4]), msize);
-				break;
+
+	for(; i < nb; i++)
+	{
+		(void)memcpy(&word, &p_src[i * (uint32_t)4], 4);
+		word = VL53L8CX_BE32_TO_HOST(word);
+		VL53L8CX_DECODE_CRC_TERM(checksum, crc_index + i, word);
+		p_dst[i] = word >> shift;
+	}
+
+	return checksum;
+}
+
+static inline uint32_t _vl53l8cx_decode_u16(
+		uint16_t			*p_dst,
+		const uint8_t			*p_src,
+		uint32_t			nb,
+		uint8_t				shift,
+		uint32_t			crc_index)
+{
+	uint32_t i = 0, word, checksum = 0;
+#if defined(VL53L8CX_SIMD_SSE2)
+	__m128i v;
+	VL53L8CX_CRC_DECLARE;
+	const __m128i count = _mm_cvtsi32_si128((int32_t)shift);
+
+	VL53L8CX_DECODE_CRC_INIT(crc_index, acc, indexes);
+	for(; (i + (uint32_t)8) <= nb; i += (uint32_t)8)
+	{
+		VL53L8CX_LOAD_BE32X4(&p_src[i * (uint32_t)2], v);
+		VL53L8CX_DECODE_CRC_ADD(v, acc, indexes);
+		_mm_storeu_si128((__m128i *)(void *)&p_dst[i],
+			_mm_srl_epi16(v, count));
+	}
+	VL53L8CX_DECODE_CRC_FOLD(checksum, acc, indexes);
+#elif defined(VL53L8CX_SIMD_NEON)
+	uint8x16_t v;
+	VL53L8CX_CRC_DECLARE;
+	const int16x8_t count = vdupq_n_s16(-(int16_t)shift);
+
+	VL53L8CX_DECODE_CRC_INIT(crc_index, acc, indexes);
+	for(; (i + (uint32_t)8) <= nb; i += (uint32_t)8)
+	{
+		VL53L8CX_LOAD_BE32X4(&p_src[i * (uint32_t)2], v);
+		VL53L8CX_DECODE_CRC_ADD(v, acc, indexes);
+		vst1q_u16(&p_dst[i], vshlq_u16(vreinterpretq_u16_u8(v), count));
+	}
+	VL53L8CX_DECODE_CRC_FOLD(checksum, acc, indexes);
 #endif
-#ifndef VL53L8CX_DISABLE_TARGET_STATUS
-			case VL53L8CX_TARGET_STATUS_IDX:
-				(void)memcpy(p_results->target_status,
-				&(p_dev->temp_buffer[i + (uint32_t)4]), msize);
-				break;
+
+	for(; i < nb; i += (uint32_t)2)
+	{
+		(void)memcpy(&word, &p_src[i * (uint32_t)2], 4);
+		word = VL53L8CX_BE32_TO_HOST(word);
+		VL53L8CX_DECODE_CRC_TERM(checksum, crc_index + (i / (uint32_t)2), word);
+		p_dst[i] = (uint16_t)((word & (uint32_t)0xffff) >> shift);
+		if((i + (uint32_t)1) < nb)
+		{
+			p_dst[i + (uint32_t)1] = (uint16_t)((word >> 16) >> shift);
+		}
+	}
+
+	return checksum;
+}
+
+static inline uint32_t _vl53l8cx_decode_i16(
+		int16_t				*p_dst,
+		const uint8_t			*p_src,
+		uint32_t			nb,
+		uint8_t				shift,
+		uint32_t			crc_index)
+{
+	uint32_t i = 0, word, checksum = 0;
+	int32_t low, high;
+	const int32_t bias = ((int32_t)1 << shift) - (int32_t)1;
+#if defined(VL53L8CX_SIMD_SSE2)
+	__m128i v;
+	VL53L8CX_CRC_DECLARE;
+	const __m128i count = _mm_cvtsi32_si128((int32_t)shift);
+	const __m128i bias_x8 = _mm_set1_epi16((int16_t)bias);
+#elif defined(VL53L8CX_SIMD_NEON)
+	uint8x16_t v;
+	int16x8_t values;
+	VL53L8CX_CRC_DECLARE;
+	const int16x8_t count = vdupq_n_s16(-(int16_t)shift);
+	const int16x8_t bias_x8 = vdupq_n_s16((int16_t)bias);
 #endif
-#ifndef VL53L8CX_DISABLE_MOTION_INDICATOR
-			case VL53L8CX_MOTION_DETEC_IDX:
-				(void)memcpy(&p_results->motion_indicator,
-				&(p_dev->temp_buffer[i + (uint32_t)4]), msize);
-				break;
+
+	/* Division by 2^shift rounded towards 0 as the '/' operator: negative
+	 * values are biased by 2^shift - 1 before the shift */
+#if defined(VL53L8CX_SIMD_SSE2)
+	VL53L8CX_DECODE_CRC_INIT(crc_index, acc, indexes);
+	for(; (i + (uint32_t)8) <= nb; i += (uint32_t)8)
+	{
+		VL53L8CX_LOAD_BE32X4(&p_src[i * (uint32_t)2], v);
+		VL53L8CX_DECODE_CRC_ADD(v, acc, indexes);
+		v = _mm_add_epi16(v,
+			_mm_and_si128(_mm_srai_epi16(v, 15), bias_x8));
+		_mm_storeu_si128((__m128i *)(void *)&p_dst[i],
+			_mm_sra_epi16(v, count));
+	}
+	VL53L8CX_DECODE_CRC_FOLD(checksum, acc, indexes);
+#elif defined(VL53L8CX_SIMD_NEON)
+	VL53L8CX_DECODE_CRC_INIT(crc_index, acc, indexes);
+	for(; (i + (uint32_t)8) <= nb; i += (uint32_t)8)
+	{
+		VL53L8CX_LOAD_BE32X4(&p_src[i * (uint32_t)2], v);
+		VL53L8CX_DECODE_CRC_ADD(v, acc, indexes);
+		values = vreinterpretq_s16_u8(v);
+		values = vaddq_s16(values,
+			vandq_s16(vshrq_n_s16(values, 15), bias_x8));
+		vst1q_s16(&p_dst[i], vshlq_s16(values, count));
+	}
+	VL53L8CX_DECODE_CRC_FOLD(checksum, acc, indexes);
 #endif
-			default:
-				break;
+
+	for(; i < nb; i += (uint32_t)2)
+	{
+		(void)memcpy(&word, &p_src[i * (uint32_t)2], 4);
+		word = VL53L8CX_BE32_TO_HOST(word);
+		VL53L8CX_DECODE_CRC_TERM(checksum, crc_index + (i / (uint32_t)2), word);
+		low = (int32_t)(int16_t)(uint16_t)word;
+		high = (int32_t)(int16_t)(uint16_t)(word >> 16);
+		p_dst[i] = (int16_t)((low + ((low >> 31) & bias)) >> shift);
+		if((i + (uint32_t)1) < nb)
+		{
+			p_dst[i + (uint32_t)1] =
+				(int16_t)((high + ((high >> 31) & bias)) >> shift);
 		}
-		i += msize;
 	}
 
-#ifndef VL53L8CX_USE_RAW_FORMAT
+	return checksum;
+}
 
-	/* Convert data into their real format */
-#ifndef VL53L8CX_DISABLE_AMBIENT_PER_SPAD
-	for(i = 0; i < (uint32_t)VL53L8CX_RESOLUTION_8X8; i++)
+static inline uint32_t _vl53l8cx_decode_u8(
+		uint8_t				*p_dst,
+		const uint8_t			*p_src,
+		uint32_t			nb,
+		uint8_t				shift,
+		uint32_t			crc_index)
+{
+	uint32_t i = 0, word, checksum = 0;
+#if defined(VL53L8CX_SIMD_SSE2)
+	__m128i v;
+	VL53L8CX_CRC_DECLARE;
+	const __m128i count = _mm_cvtsi32_si128((int32_t)shift);
+	const __m128i mask = _mm_set1_epi8((char)(0xff >> shift));
+
+	/* No 8 bits shift: 16 bits shift, without the bits of the next byte */
+	VL53L8CX_DECODE_CRC_INIT(crc_index, acc, indexes);
+	for(; (i + (uint32_t)16) <= nb; i += (uint32_t)16)
+	{
+		VL53L8CX_LOAD_BE32X4(&p_src[i], v);
+		VL53L8CX_DECODE_CRC_ADD(v, acc, indexes);
+		_mm_storeu_si128((__m128i *)(void *)&p_dst[i],
+			_mm_and_si128(_mm_srl_epi16(v, count), mask));
+	}
+	VL53L8CX_DECODE_CRC_FOLD(checksum, acc, indexes);
+#elif defined(VL53L8CX_SIMD_NEON)
+	uint8x16_t v;
+	VL53L8CX_CRC_DECLARE;
+	const int8x16_t count = vdupq_n_s8(-(int8_t)shift);
+
+	VL53L8CX_DECODE_CRC_INIT(crc_index, acc, indexes);
+	for(; (i + (uint32_t)16) <= nb; i += (uint32_t)16)
+	{
+		VL53L8CX_LOAD_BE32X4(&p_src[i], v);
+		VL53L8CX_DECODE_CRC_ADD(v, acc, indexes);
+		vst1q_u8(&p_dst[i], vshlq_u8(v, count));
+	}
+	VL53L8CX_DECODE_CRC_FOLD(checksum, acc, indexes);
+#endif
+
+	for(; (i + (uint32_t)4) <= nb; i += (uint32_t)4)
+	{
+		(void)memcpy(&word, &p_src[i], 4);
+		word = VL53L8CX_BE32_TO_HOST(word);
+		VL53L8CX_DECODE_CRC_TERM(checksum, crc_index + (i / (uint32_t)4), word);
+		p_dst[i] = (uint8_t)word >> shift;
+		p_dst[i + (uint32_t)1] = (uint8_t)(word >> 8) >> shift;
+		p_dst[i + (uint32_t)2] = (uint8_t)(word >> 16) >> shift;
+		p_dst[i + (uint32_t)3] = (uint8_t)(word >> 24) >> shift;
+	}
+	for(; i < nb; i++)
+	{
+		p_dst[i] = p_src[i ^ (uint32_t)3] >> shift;
+	}
+
+	return checksum;
+}
+
+static inline void _vl53l8cx_mark_no_target(
+		uint8_t				*p_target_status,
+		const uint8_t			*p_nb_target_detected,
+		uint32_t			nb,
+		uint8_t				nb_target_per_zone)
+{
+	uint32_t i = 0;
+#if defined(VL53L8CX_SIMD_SSE2)
+	__m128i v;
+
+	/* 0xff where no target is detected, with 1 target per zone */
+	for(; (nb_target_per_zone == (uint8_t)1)
+		&& ((i + (uint32_t)16) <= nb); i += (uint32_t)16)
+	{
+		v = _mm_cmpeq_epi8(_mm_loadu_si128(
+			(const __m128i *)(const void *)&p_nb_target_detected[i]),
+			_mm_setzero_si128());
+		v = _mm_or_si128(v, _mm_loadu_si128(
+			(const __m128i *)(const void *)&p_target_status[i]));
+		_mm_storeu_si128((__m128i *)(void *)&p_target_status[i], v);
+	}
+#elif defined(VL53L8CX_SIMD_NEON)
+	for(; (nb_target_per_zone == (uint8_t)1)
+		&& ((i + (uint32_t)16) <= nb); i += (uint32_t)16)
 	{
-		p_results->ambient_per_spad[i] /= (uint32_t)2048;
+		vst1q_u8(&p_target_status[i], vorrq_u8(
+			vceqq_u8(vld1q_u8(&p_nb_target_detected[i]),
+				vdupq_n_u8(0)),
+			vld1q_u8(&p_target_status[i])));
 	}
 #endif
 
-	for(i = 0; i < (uint32_t)(VL53L8CX_RESOLUTION_8X8
-			*VL53L8CX_NB_TARGET_PER_ZONE); i++)
+	for(; i < nb; i++)
 	{
+		if(p_nb_target_detected[
+			i / (uint32_t)nb_target_per_zone] == (uint8_t)0)
+		{
+			p_target_status[i] = (uint8_t)255;
+		}
+	}
+}
+
+/**
+ * @brief Inner function, not available outside this file. This function
+ * computes vl53l8cx_generate_crc_checksum() on words in the firmware byte
+ * order, the first one being at crc_index.
+ */
+
+static uint32_t _vl53l8cx_results_crc(
+		const uint8_t			*p_data,
+		uint32_t			nb_words,
+		uint32_t			crc_index)
+{
+	uint32_t i = 0, word, checksum = 0;
+#if defined(VL53L8CX_SIMD_SSE2)
+	__m128i v;
+	VL53L8CX_CRC_DECLARE;
+
+	VL53L8CX_CRC_INIT(crc_index, acc, indexes);
+	for(; (i + (uint32_t)4) <= nb_words; i += (uint32_t)4)
+	{
+		VL53L8CX_LOAD_BE32X4(&p_data[i * (uint32_t)4], v);
+		VL53L8CX_CRC_ADD(v, acc, indexes);
+	}
+	checksum = _vl53l8cx_crc_fold(acc);
+#elif defined(VL53L8CX_SIMD_NEON)
+	uint8x16_t v;
+	VL53L8CX_CRC_DECLARE;
+
+	VL53L8CX_CRC_INIT(crc_index, acc, indexes);
+	for(; (i + (uint32_t)4) <= nb_words; i += (uint32_t)4)
+	{
+		VL53L8CX_LOAD_BE32X4(&p_data[i * (uint32_t)4], v);
+		VL53L8CX_CRC_ADD(v, acc, indexes);
+	}
+	checksum = _vl53l8cx_crc_fold(acc);
+#endif
+
+	for(; i < nb_words; i++)
+	{
+		/* 32 bits sum, as the reference (33rd bit removed) */
+		(void)memcpy(&word, &p_data[i * (uint32_t)4], 4);
+		checksum ^= (crc_index + i) + VL53L8CX_BE32_TO_HOST(word);
+	}
+
+	return checksum;
+}
+
+/*
+ * Number of values of a block copied into an array of the results structure,
+ * limited to the array size
+ */
+#define VL53L8CX_NB_VALUES(nb, array) \
+	(((nb) < (uint32_t)(sizeof(array) / sizeof((array)[0]))) \
+	? (nb) : (uint32_t)(sizeof(array) / sizeof((array)[0])))
+
+/**
+ * @brief Inner function, not available outside this file. This function
+ * copies a block of the results into the results structure, converted from
+ * the firmware byte order with the format of the device. If p_checksum is not
+ * NULL, the checksum terms of the block data (whole words, the first one being
+ * at crc_index) are XORed into it.
+ */
+
+static void _vl53l8cx_decode_block(
+		const VL53L8CX_Configuration	*p_dev,
+		VL53L8CX_ResultsData		*p_results,
+		uint32_t			idx,
+		const uint8_t			*p_data,
+		uint32_t			msize,
+		uint32_t			*p_checksum,
+		uint32_t			crc_index)
+{
+	uint32_t checksum = 0;
+	uint8_t is_checksum_done = 0;
+#ifndef VL53L8CX_DISABLE_MOTION_INDICATOR
+	uint32_t word;
+#endif
+
+	switch(_vl53l8cx_block_output(idx)){
+		case VL53L8CX_BLOCK_METADATA:
+			p_results->silicon_temp_degc = (int8_t)p_data[11];
+			break;
+
+#ifndef VL53L8CX_DISABLE_AMBIENT_PER_SPAD
+		case VL53L8CX_BLOCK_AMBIENT_PER_SPAD:
+			checksum = _vl53l8cx_decode_u32(p_results->ambient_per_spad,
+				p_data, VL53L8CX_NB_VALUES(msize / (uint32_t)4,
+				p_results->ambient_per_spad),
+				VL53L8CX_RESULTS_SHIFT(p_dev, 11), crc_index);
+			is_checksum_done = 1;
+			break;
+#endif
+#ifndef VL53L8CX_DISABLE_NB_SPADS_ENABLED
+		case VL53L8CX_BLOCK_NB_SPADS_ENABLED:
+			checksum = _vl53l8cx_decode_u32(p_results->nb_spads_enabled,
+				p_data, VL53L8CX_NB_VALUES(msize / (uint32_t)4,
+				p_results->nb_spads_enabled), 0, crc_index);
+			is_checksum_done = 1;
+			break;
+#endif
+#ifndef VL53L8CX_DISABLE_NB_TARGET_DETECTED
+		case VL53L8CX_BLOCK_NB_TARGET_DETECTED:
+			checksum = _vl53l8cx_decode_u8(p_results->nb_target_detected,
+				p_data, VL53L8CX_NB_VALUES(msize,
+				p_results->nb_target_detected), 0, crc_index);
+			is_checksum_done = 1;
+			break;
+#endif
+#ifndef VL53L8CX_DISABLE_SIGNAL_PER_SPAD
+		case VL53L8CX_BLOCK_SIGNAL_PER_SPAD:
+			checksum = _vl53l8cx_decode_u32(p_results->signal_per_spad,
+				p_data, VL53L8CX_NB_VALUES(msize / (uint32_t)4,
+				p_results->signal_per_spad),
+				VL53L8CX_RESULTS_SHIFT(p_dev, 11), crc_index);
+			is_checksum_done = 1;
+			break;
+#endif
+#ifndef VL53L8CX_DISABLE_RANGE_SIGMA_MM
+		case VL53L8CX_BLOCK_RANGE_SIGMA_MM:
+			checksum = _vl53l8cx_decode_u16(p_results->range_sigma_mm,
+				p_data, VL53L8CX_NB_VALUES(msize / (uint32_t)2,
+				p_results->range_sigma_mm),
+				VL53L8CX_RESULTS_SHIFT(p_dev, 7), crc_index);
+			is_checksum_done = 1;
+			break;
+#endif
 #ifndef VL53L8CX_DISABLE_DISTANCE_MM
-		p_results->distance_mm[i] /= 4;
+		case VL53L8CX_BLOCK_DISTANCE_MM:
+			checksum = _vl53l8cx_decode_i16(p_results->distance_mm,
+				p_data, VL53L8CX_NB_VALUES(msize / (uint32_t)2,
+				p_results->distance_mm),
+				VL53L8CX_RESULTS_SHIFT(p_dev, 2), crc_index);
+			is_checksum_done = 1;
+			break;
 #endif
 #ifndef VL53L8CX_DISABLE_REFLECTANCE_PERCENT
-		p_results->reflectance[i] /= (uint8_t)2;
+		case VL53L8CX_BLOCK_REFLECTANCE:
+			checksum = _vl53l8cx_decode_u8(p_results->reflectance,
+				p_data, VL53L8CX_NB_VALUES(msize,
+				p_results->reflectance),
+				VL53L8CX_RESULTS_SHIFT(p_dev, 1), crc_index);
+			is_checksum_done = 1;
+			break;
 #endif
-#ifndef VL53L8CX_DISABLE_RANGE_SIGMA_MM
-		p_results->range_sigma_mm[i] /= (uint16_t)128;
+#ifndef VL53L8CX_DISABLE_TARGET_STATUS
+		case VL53L8CX_BLOCK_TARGET_STATUS:
+			checksum = _vl53l8cx_decode_u8(p_results->target_status,
+				p_data, VL53L8CX_NB_VALUES(msize,
+				p_results->target_status), 0, crc_index);
+			is_checksum_done = 1;
+			break;
 #endif
-#ifndef VL53L8CX_DISABLE_SIGNAL_PER_SPAD
-		p_results->signal_per_spad[i] /= (uint32_t)2048;
+#ifndef VL53L8CX_DISABLE_MOTION_INDICATOR
+		case VL53L8CX_BLOCK_MOTION_INDICATOR:
+		{
+			/* Indicators, status and aggregates in the first
+			 * 3 words, then the motion of each aggregate */
+			uint32_t k, nb = msize / (uint32_t)4;
+
+			if(nb > (uint32_t)(sizeof(p_results->motion_indicator)
+				/ (uint32_t)4))
+			{
+				nb = (uint32_t)(sizeof(p_results->motion_indicator)
+					/ (uint32_t)4);
+			}
+
+			for(k = 0; (k < (uint32_t)3) && (k < nb); k++)
+			{
+				word = _vl53l8cx_be32(&p_data[k * (uint32_t)4]);
+				(void)memcpy(&((uint8_t *)&p_results->motion_indicator)
+					[k * (uint32_t)4], &word, 4);
+			}
+			for(; k < nb; k++)
+			{
+				(void)memcpy(&word, &p_data[k * (uint32_t)4], 4);
+				p_results->motion_indicator.motion[k - (uint32_t)3] =
+					VL53L8CX_BE32_TO_HOST(word)
+					/ VL53L8CX_MOTION_DIVIDER(p_dev);
+			}
+			break;
+		}
 #endif
+		default:
+			break;
 	}
 
-	/* Set target status to 255 if no target is detected for this zone */
-#ifndef VL53L8CX_DISABLE_NB_TARGET_DETECTED
-	for(i = 0; i < (uint32_t)VL53L8CX_RESOLUTION_8X8; i++)
+	if(p_checksum != NULL)
 	{
-		if(p_results->nb_target_detected[i] == (uint8_t)0){
-			for(j = 0; j < (uint32_t)
-				VL53L8CX_NB_TARGET_PER_ZONE; j++)
-			{
-#ifndef VL53L8CX_DISABLE_TARGET_STATUS
-				p_results->target_status
-				[((uint32_t)VL53L8CX_NB_TARGET_PER_ZONE
-					*(uint32_t)i) + j]=(uint8_t)255;
-#endif
-			}
+		if(is_checksum_done == (uint8_t)0)
+		{
+			checksum = _vl53l8cx_results_crc(p_data,
+				msize / (uint32_t)4, crc_index);
 		}
+		*p_checksum ^= checksum;
 	}
-#endif
+}
 
-#ifndef VL53L8CX_DISABLE_MOTION_INDICATOR
-	for(i = 0; i < (uint32_t)32; i++)
+/**
+ * @brief Inner function, not available outside this file. This function
+ * returns 0 if every block header of the frame matches the layout computed by
+ * vl53l8cx_start_ranging().
+ */
+
+static uint32_t _vl53l8cx_layout_mismatch(
+		const VL53L8CX_Configuration	*p_dev)
+{
+	uint32_t i, mismatch;
+	const VL53L8CX_BlockLayout *p_block;
+
+	mismatch = (p_dev->layout_nb_blocks == (uint8_t)0) ? (uint32_t)1 : 0;
+	for (i = 0; i < (uint32_t)p_dev->layout_nb_blocks; i++)
 	{
-		p_results->motion_indicator.motion[i] /= (uint32_t)65535;
+		p_block = &(p_dev->layout[i]);
+		mismatch |= _vl53l8cx_be32(&(p_dev->temp_buffer[
+			p_block->offset - (uint16_t)4])) ^ p_block->header;
 	}
-#endif
 
-#endif
+	return mismatch;
+}
+
+/**
+ * @brief Inner function, not available outside this file. This function
+ * checks the header and footer ids of the frame, and its CRC if enabled. The
+ * CRC is computed unless p_checksum gives it.
+ */
+
+static uint8_t _vl53l8cx_check_frame(
+		const VL53L8CX_Configuration	*p_dev,
+		uint8_t				status,
+		const uint32_t			*p_checksum)
+{
+	uint16_t header_id, footer_id;
 
 	/* Check if footer id and header id are matching. This allows to detect
 	 * corrupted frames */
-	header_id = *((uint16_t *)(&p_dev->temp_buffer[0x8]));
-	footer_id = *((uint16_t *)(&p_dev->temp_buffer[p_dev->data_read_size-(uint32_t)12]));
+	header_id = (uint16_t)(((uint16_t)p_dev->temp_buffer[0xa] << 8)
+		| (uint16_t)p_dev->temp_buffer[0xb]);
+	footer_id = (uint16_t)(((uint16_t)p_dev->temp_buffer[p_dev->data_read_size-(uint32_t)10] << 8)
+		| (uint16_t)p_dev->temp_buffer[p_dev->data_read_size-(uint32_t)9]);
 
 	if(header_id != footer_id)
 	{
@@ -904,19 +1849,378 @@ uint8_t vl53l8cx_get_ranging_data(
 	    /* Only if the CRC for results packet feature is enabled then read the CRC that was appended    */
 	    /* to the results packet and compare it to CRC calculated from the contents of the results      */
 	    /* packet. Flag an error if they are different.                                                 */
+	    /* The CRC is already calculated if the blocks were decoded from their known positions.         */
         uint32_t crc_from_packet, calculated_crc;
-        calculated_crc = 0;
-        crc_from_packet = 0;
-        crc_from_packet =  *((uint32_t *)&p_dev->temp_buffer[p_dev->data_read_size-(uint32_t)8]);
-        calculated_crc = vl53l8cx_generate_crc_checksum((uint32_t *)&p_dev->temp_buffer[4], (p_dev->data_read_size - 12)/sizeof(uint32_t));
+        crc_from_packet = _vl53l8cx_be32(&p_dev->temp_buffer[p_dev->data_read_size-(uint32_t)8]);
+        if (p_checksum == NULL)
+            calculated_crc = _vl53l8cx_results_crc(&p_dev->temp_buffer[4], (p_dev->data_read_size - 12)/sizeof(uint32_t), 0);
+        else
+            calculated_crc = *p_checksum;
         if(crc_from_packet != calculated_crc)
-            return VL53L8CX_STATUS_CORRUPTED_FRAME;
+            status = VL53L8CX_STATUS_CORRUPTED_FRAME;
+	}
+
+	return status;
+}
+
+uint8_t vl53l8cx_get_ranging_data(
+		VL53L8CX_Configuration		*p_dev,
+		VL53L8CX_ResultsData		*p_results)
+{
+	uint8_t status = VL53L8CX_STATUS_OK;
+	uint32_t i, word, type, msize, crc_start;
+	uint32_t calculated_crc = 0, *p_checksum = NULL;
+	const VL53L8CX_BlockLayout *p_block;
+	uint64_t stats_us = VL53L8CX_StatsStart();
+
+	p_dev->view.is_valid = (uint8_t)0;
+	status |= VL53L8CX_RdMulti(&(p_dev->platform), 0x0,
+			p_dev->temp_buffer, p_dev->data_read_size);
+	p_dev->streamcount = p_dev->temp_buffer[0];
+
+	/* Blocks are decoded from the firmware byte order, without swapping the
+	 * buffer. The positions computed by vl53l8cx_start_ranging() are used
+	 * when every block header of the frame matches them */
+	if (_vl53l8cx_layout_mismatch(p_dev) == (uint32_t)0)
+	{
+		/* The CRC of the results packet covers the frame from position
+		 * 4, without the CRC itself. With VL53L8CX_FUSED_RESULTS_CRC,
+		 * the words of the blocks are added while decoding them, and
+		 * the words in between (headers and footer) separately */
+#ifdef VL53L8CX_FUSED_RESULTS_CRC
+		if (p_dev->crc_checksum_for_results_pkt != (uint8_t)0)
+		{
+			p_checksum = &calculated_crc;
+		}
+#endif
+		crc_start = 4;
+		for (i = 0; i < (uint32_t)p_dev->layout_nb_blocks; i++)
+		{
+			p_block = &(p_dev->layout[i]);
+			if (p_checksum != NULL)
+			{
+				calculated_crc ^= _vl53l8cx_results_crc(
+					&(p_dev->temp_buffer[crc_start]),
+					((uint32_t)p_block->offset - crc_start) / (uint32_t)4,
+					(crc_start - (uint32_t)4) / (uint32_t)4);
+				crc_start = (uint32_t)p_block->offset
+					+ (uint32_t)p_block->size;
+			}
+			_vl53l8cx_decode_block(p_dev, p_results,
+				p_block->header >> 16,
+				&(p_dev->temp_buffer[p_block->offset]),
+				p_block->size, p_checksum,
+				((uint32_t)p_block->offset - (uint32_t)4) / (uint32_t)4);
+		}
+		if (p_checksum != NULL)
+		{
+			calculated_crc ^= _vl53l8cx_results_crc(
+				&(p_dev->temp_buffer[crc_start]),
+				(p_dev->data_read_size - (uint32_t)8 - crc_start)
+					/ (uint32_t)4,
+				(crc_start - (uint32_t)4) / (uint32_t)4);
+		}
 	}
+	else
+	{
+		/* Walk the block headers. Start at position 16 to avoid
+		 * headers */
+		for (i = (uint32_t)16; i
+			< (uint32_t)p_dev->data_read_size; i+=(uint32_t)4)
+		{
+			word = _vl53l8cx_be32(&(p_dev->temp_buffer[i]));
+			type = word & (uint32_t)0xf;
+			if ((type > (uint32_t)0x1)
+				&& (type < (uint32_t)0xd))
+			{
+				msize = type * ((word >> 4) & (uint32_t)0xfff);
+			}
+			else
+			{
+				msize = (word >> 4) & (uint32_t)0xfff;
+			}
+			if ((i + (uint32_t)4 + msize)
+				> (uint32_t)p_dev->data_read_size)
+			{
+				break;
+			}
+			_vl53l8cx_decode_block(p_dev, p_results,
+				word >> 16,
+				&(p_dev->temp_buffer[i + (uint32_t)4]), msize,
+				NULL, 0);
+			i += msize;
+		}
+	}
+
+#if !defined(VL53L8CX_DISABLE_NB_TARGET_DETECTED) \
+	&& !defined(VL53L8CX_DISABLE_TARGET_STATUS)
+	/* Set target status to 255 if no target is detected for this zone,
+	 * also when the frame has no target status block */
+	if((p_dev->is_raw_format == (uint8_t)0)
+		&& ((p_dev->outputs
+		& VL53L8CX_OUTPUT_NB_TARGET_DETECTED) != (uint16_t)0))
+	{
+		_vl53l8cx_mark_no_target(p_results->target_status,
+			p_results->nb_target_detected,
+			(uint32_t)VL53L8CX_RESOLUTION_8X8
+				* (uint32_t)p_dev->nb_target_per_zone,
+			p_dev->nb_target_per_zone);
+	}
+#endif
 
+	status = _vl53l8cx_check_frame(p_dev, status, p_checksum);
 
+	VL53L8CX_StatsAdd(&(p_dev->platform), VL53L8CX_STATS_RANGING_DATA,
+		stats_us, p_dev->data_read_size, status);
 	return status;
 }
 
+/**
+ * @brief Inner function, not available outside this file. This function
+ * records the position of a block of the frame in the results view.
+ */
+
+static void _vl53l8cx_view_add_block(
+		VL53L8CX_ResultsView		*p_view,
+		uint32_t			idx,
+		uint32_t			offset,
+		uint32_t			msize)
+{
+	uint8_t output = _vl53l8cx_block_output(idx);
+
+	if(output < VL53L8CX_NB_VIEW_OUTPUTS)
+	{
+		p_view->offset[output] = (uint16_t)offset;
+		p_view->size[output] = (uint16_t)msize;
+	}
+}
+
+uint8_t vl53l8cx_get_ranging_view(
+		VL53L8CX_Configuration		*p_dev)
+{
+	uint8_t status = VL53L8CX_STATUS_OK;
+	uint32_t i, word, type, msize;
+	const VL53L8CX_BlockLayout *p_block;
+	uint64_t stats_us = VL53L8CX_StatsStart();
+
+	(void)memset(&(p_dev->view), 0, sizeof(p_dev->view));
+	status |= VL53L8CX_RdMulti(&(p_dev->platform), 0x0,
+			p_dev->temp_buffer, p_dev->data_read_size);
+	p_dev->streamcount = p_dev->temp_buffer[0];
+
+	/* Only the positions of the blocks are read here, the outputs are
+	 * converted when accessed */
+	if (_vl53l8cx_layout_mismatch(p_dev) == (uint32_t)0)
+	{
+		for (i = 0; i < (uint32_t)p_dev->layout_nb_blocks; i++)
+		{
+			p_block = &(p_dev->layout[i]);
+			_vl53l8cx_view_add_block(&(p_dev->view),
+				p_block->header >> 16, p_block->offset,
+				p_block->size);
+		}
+	}
+	else
+	{
+		/* Walk the block headers. The outputs are converted in place:
+		 * only whole blocks of whole words are kept */
+		for (i = (uint32_t)16; (i + (uint32_t)4)
+			<= (uint32_t)p_dev->data_read_size; i+=(uint32_t)4)
+		{
+			word = _vl53l8cx_be32(&(p_dev->temp_buffer[i]));
+			type = word & (uint32_t)0xf;
+			if ((type > (uint32_t)0x1)
+				&& (type < (uint32_t)0xd))
+			{
+				msize = type * ((word >> 4) & (uint32_t)0xfff);
+			}
+			else
+			{
+				msize = (word >> 4) & (uint32_t)0xfff;
+			}
+			if (((msize & (uint32_t)3) != (uint32_t)0)
+				|| ((i + (uint32_t)4 + msize)
+				> (uint32_t)p_dev->data_read_size))
+			{
+				break;
+			}
+			_vl53l8cx_view_add_block(&(p_dev->view), word >> 16,
+				i + (uint32_t)4, msize);
+			i += msize;
+		}
+	}
+
+	status = _vl53l8cx_check_frame(p_dev, status, NULL);
+	p_dev->view.is_valid = (uint8_t)1;
+
+	VL53L8CX_StatsAdd(&(p_dev->platform), VL53L8CX_STATS_RANGING_DATA,
+		stats_us, p_dev->data_read_size, status);
+	return status;
+}
+
+/**
+ * @brief Inner function, not available outside this file. This function
+ * returns the data of an output of the results view, converted in place
+ * from the firmware byte order on the first access. The temporary buffer is
+ * word aligned, as the blocks of the frame.
+ */
+
+static uint8_t *_vl53l8cx_view_output(
+		VL53L8CX_Configuration		*p_dev,
+		uint8_t				output)
+{
+	VL53L8CX_ResultsView *p_view = &(p_dev->view);
+	uint8_t *p_data = NULL;
+	uint32_t size, k, word;
+	const uint8_t *p_nb_target_detected;
+
+	if((p_view->is_valid == (uint8_t)0)
+		|| (p_view->offset[output] == (uint16_t)0))
+	{
+		return NULL;
+	}
+
+	p_data = &(p_dev->temp_buffer[p_view->offset[output]]);
+	size = (uint32_t)p_view->size[output];
+	if((p_view->converted & ((uint16_t)1 << output)) != (uint16_t)0)
+	{
+		return p_data;
+	}
+	p_view->converted |= (uint16_t)1 << output;
+
+	switch(output){
+		case VL53L8CX_BLOCK_AMBIENT_PER_SPAD:
+		case VL53L8CX_BLOCK_SIGNAL_PER_SPAD:
+			(void)_vl53l8cx_decode_u32((uint32_t *)(void *)p_data,
+				p_data, size / (uint32_t)4,
+				VL53L8CX_RESULTS_SHIFT(p_dev, 11), 0);
+			break;
+		case VL53L8CX_BLOCK_NB_SPADS_ENABLED:
+			(void)_vl53l8cx_decode_u32((uint32_t *)(void *)p_data,
+				p_data, size / (uint32_t)4, 0, 0);
+			break;
+		case VL53L8CX_BLOCK_NB_TARGET_DETECTED:
+			(void)_vl53l8cx_decode_u8(p_data, p_data, size, 0, 0);
+			break;
+		case VL53L8CX_BLOCK_RANGE_SIGMA_MM:
+			(void)_vl53l8cx_decode_u16((uint16_t *)(void *)p_data,
+				p_data, size / (uint32_t)2,
+				VL53L8CX_RESULTS_SHIFT(p_dev, 7), 0);
+			break;
+		case VL53L8CX_BLOCK_DISTANCE_MM:
+			(void)_vl53l8cx_decode_i16((int16_t *)(void *)p_data,
+				p_data, size / (uint32_t)2,
+				VL53L8CX_RESULTS_SHIFT(p_dev, 2), 0);
+			break;
+		case VL53L8CX_BLOCK_REFLECTANCE:
+			(void)_vl53l8cx_decode_u8(p_data, p_data, size,
+				VL53L8CX_RESULTS_SHIFT(p_dev, 1), 0);
+			break;
+		case VL53L8CX_BLOCK_TARGET_STATUS:
+			(void)_vl53l8cx_decode_u8(p_data, p_data, size, 0, 0);
+			/* Set target status to 255 if no target is detected
+			 * for this zone */
+			if(p_dev->is_raw_format == (uint8_t)0)
+			{
+				p_nb_target_detected = _vl53l8cx_view_output(
+					p_dev, VL53L8CX_BLOCK_NB_TARGET_DETECTED);
+				if(p_nb_target_detected != NULL)
+				{
+					_vl53l8cx_mark_no_target(p_data,
+						p_nb_target_detected, size,
+						p_dev->nb_target_per_zone);
+				}
+			}
+			break;
+		case VL53L8CX_BLOCK_MOTION_INDICATOR:
+			/* Same layout as VL53L8CX_MotionIndicator once the
+			 * words are converted */
+			(void)_vl53l8cx_decode_u32((uint32_t *)(void *)p_data,
+				p_data, size / (uint32_t)4, 0, 0);
+			for(k = (uint32_t)12; k < size; k += (uint32_t)4)
+			{
+				(void)memcpy(&word, &p_data[k], 4);
+				word /= VL53L8CX_MOTION_DIVIDER(p_dev);
+				(void)memcpy(&p_data[k], &word, 4);
+			}
+			break;
+		default:
+			/* Metadata, read as is */
+			break;
+	}
+
+	return p_data;
+}
+
+const int8_t *vl53l8cx_view_silicon_temp_degc(
+		VL53L8CX_Configuration		*p_dev)
+{
+	const uint8_t *p_data = _vl53l8cx_view_output(p_dev,
+		VL53L8CX_BLOCK_METADATA);
+
+	return (p_data != NULL) ? (const int8_t *)&p_data[11] : NULL;
+}
+
+const uint32_t *vl53l8cx_view_ambient_per_spad(
+		VL53L8CX_Configuration		*p_dev)
+{
+	return (const uint32_t *)(const void *)_vl53l8cx_view_output(p_dev,
+		VL53L8CX_BLOCK_AMBIENT_PER_SPAD);
+}
+
+const uint8_t *vl53l8cx_view_nb_target_detected(
+		VL53L8CX_Configuration		*p_dev)
+{
+	return _vl53l8cx_view_output(p_dev, VL53L8CX_BLOCK_NB_TARGET_DETECTED);
+}
+
+const uint32_t *vl53l8cx_view_nb_spads_enabled(
+		VL53L8CX_Configuration		*p_dev)
+{
+	return (const uint32_t *)(const void *)_vl53l8cx_view_output(p_dev,
+		VL53L8CX_BLOCK_NB_SPADS_ENABLED);
+}
+
+const uint32_t *vl53l8cx_view_signal_per_spad(
+		VL53L8CX_Configuration		*p_dev)
+{
+	return (const uint32_t *)(const void *)_vl53l8cx_view_output(p_dev,
+		VL53L8CX_BLOCK_SIGNAL_PER_SPAD);
+}
+
+const uint16_t *vl53l8cx_view_range_sigma_mm(
+		VL53L8CX_Configuration		*p_dev)
+{
+	return (const uint16_t *)(const void *)_vl53l8cx_view_output(p_dev,
+		VL53L8CX_BLOCK_RANGE_SIGMA_MM);
+}
+
+const int16_t *vl53l8cx_view_distance_mm(
+		VL53L8CX_Configuration		*p_dev)
+{
+	return (const int16_t *)(const void *)_vl53l8cx_view_output(p_dev,
+		VL53L8CX_BLOCK_DISTANCE_MM);
+}
+
+const uint8_t *vl53l8cx_view_reflectance(
+		VL53L8CX_Configuration		*p_dev)
+{
+	return _vl53l8cx_view_output(p_dev, VL53L8CX_BLOCK_REFLECTANCE);
+}
+
+const uint8_t *vl53l8cx_view_target_status(
+		VL53L8CX_Configuration		*p_dev)
+{
+	return _vl53l8cx_view_output(p_dev, VL53L8CX_BLOCK_TARGET_STATUS);
+}
+
+const VL53L8CX_MotionIndicator *vl53l8cx_view_motion_indicator(
+		VL53L8CX_Configuration		*p_dev)
+{
+	return (const VL53L8CX_MotionIndicator *)(const void *)
+		_vl53l8cx_view_output(p_dev, VL53L8CX_BLOCK_MOTION_INDICATOR);
+}
+
 uint8_t vl53l8cx_get_resolution(
 		VL53L8CX_Configuration		*p_dev,
 		uint8_t				*p_resolution)
@@ -991,8 +2295,16 @@ uint8_t vl53l8cx_set_resolution(
 			break;
 		}
 
-	status |= _vl53l8cx_send_offset_data(p_dev, resolution);
-	status |= _vl53l8cx_send_xtalk_data(p_dev, resolution);
+	if(p_dev->config_staging != (uint8_t)0)
+	{
+		/* Sent once by vl53l8cx_commit_config() */
+		p_dev->config_caldata_pending = (uint8_t)1;
+	}
+	else
+	{
+		status |= _vl53l8cx_send_offset_data(p_dev, resolution);
+		status |= _vl53l8cx_send_xtalk_data(p_dev, resolution);
+	}
 
 	return status;
 }
@@ -1269,6 +2581,91 @@ uint8_t vl53l8cx_set_VHV_repeat_count(
 	return status;
 }
 
+uint8_t vl53l8cx_begin_config(
+		VL53L8CX_Configuration		*p_dev)
+{
+	p_dev->config_staging = (uint8_t)1;
+	return VL53L8CX_STATUS_OK;
+}
+
+uint8_t vl53l8cx_commit_config(
+		VL53L8CX_Configuration		*p_dev)
+{
+	uint8_t status = VL53L8CX_STATUS_OK, write_status, resolution;
+	uint8_t i, j, last;
+	uint16_t offset = 0, run_size, size, mask;
+	uint8_t run[VL53L8CX_DCI_SHADOW_SIZE];
+
+	p_dev->config_staging = (uint8_t)0;
+
+	i = 0;
+	while(i < VL53L8CX_DCI_SHADOW_NB_BLOCKS)
+	{
+		if((p_dev->dci_shadow_dirty & ((uint16_t)1 << i)) == (uint16_t)0)
+		{
+			offset += _vl53l8cx_dci_shadow_size[i];
+			i++;
+			continue;
+		}
+
+		/* Extend the write over the following adjacent blocks, up to
+		 * the last modified one */
+		last = i;
+		size = _vl53l8cx_dci_shadow_size[i];
+		run_size = size;
+		mask = (uint16_t)1 << i;
+		for(j = i + (uint8_t)1; j < VL53L8CX_DCI_SHADOW_NB_BLOCKS; j++)
+		{
+			if((_vl53l8cx_dci_shadow_index[j] != (_vl53l8cx_dci_shadow_index[j - 1U]
+					+ _vl53l8cx_dci_shadow_size[j - 1U]))
+				|| ((p_dev->dci_shadow_valid & ((uint16_t)1 << j)) == (uint16_t)0))
+			{
+				break;
+			}
+			size += _vl53l8cx_dci_shadow_size[j];
+			if((p_dev->dci_shadow_dirty & ((uint16_t)1 << j)) != (uint16_t)0)
+			{
+				last = j;
+				run_size = size;
+			}
+		}
+		for(j = i + (uint8_t)1; j <= last; j++)
+		{
+			mask |= (uint16_t)1 << j;
+		}
+
+		(void)memcpy(run, &(p_dev->dci_shadow[offset]), run_size);
+		write_status = vl53l8cx_dci_write_data(p_dev, run,
+				_vl53l8cx_dci_shadow_index[i], run_size);
+		p_dev->dci_shadow_dirty &= ~mask;
+		if(write_status != VL53L8CX_STATUS_OK)
+		{
+			p_dev->dci_shadow_valid &= ~mask;
+		}
+		status |= write_status;
+
+		offset += run_size;
+		i = last + (uint8_t)1;
+	}
+
+	if(p_dev->config_caldata_pending != (uint8_t)0)
+	{
+		p_dev->config_caldata_pending = (uint8_t)0;
+		status |= vl53l8cx_get_resolution(p_dev, &resolution);
+		status |= _vl53l8cx_send_offset_data(p_dev, resolution);
+		status |= _vl53l8cx_send_xtalk_data(p_dev, resolution);
+	}
+
+	return status;
+}
+
+void vl53l8cx_dci_invalidate_shadow(
+		VL53L8CX_Configuration		*p_dev)
+{
+	p_dev->dci_shadow_valid = (uint16_t)0;
+	p_dev->dci_shadow_dirty = (uint16_t)0;
+}
+
 uint8_t vl53l8cx_dci_read_data(
 		VL53L8CX_Configuration		*p_dev,
 		uint8_t				*data,
@@ -1276,17 +2673,30 @@ uint8_t vl53l8cx_dci_read_data(
 		uint16_t			data_size)
 {
 	int16_t i;
+	int8_t block;
+	uint16_t offset = 0;
 	uint8_t status = VL53L8CX_STATUS_OK;
         uint32_t rd_size = (uint32_t) data_size + (uint32_t)12;
 	uint8_t cmd[] = {0x00, 0x00, 0x00, 0x00,
 			0x00, 0x00, 0x00, 0x0f,
 			0x00, 0x02, 0x00, 0x08};
+	uint64_t stats_us = VL53L8CX_StatsStart();
+
+	/* The temporary buffer may be overwritten */
+	p_dev->view.is_valid = (uint8_t)0;
+	block = _vl53l8cx_dci_shadow_find(index, data_size, &offset);
 
 	/* Check if tmp buffer is large enough */
 	if((data_size + (uint16_t)12)>(uint16_t)VL53L8CX_TEMPORARY_BUFFER_SIZE)
 	{
 		status |= VL53L8CX_STATUS_ERROR;
 	}
+	else if((block >= (int8_t)0)
+		&& ((p_dev->dci_shadow_valid & ((uint16_t)1 << block)) != (uint16_t)0))
+	{
+		/* Block already known, no need to ask the FW */
+		(void)memcpy(data, &(p_dev->dci_shadow[offset]), data_size);
+	}
 	else
 	{
 		cmd[0] = (uint8_t)(index >> 8);	
@@ -1310,8 +2720,16 @@ uint8_t vl53l8cx_dci_read_data(
 		for(i = 0 ; i < (int16_t)data_size;i++){
 			data[i] = p_dev->temp_buffer[i + 4];
 		}
+
+		if((block >= (int8_t)0) && (status == VL53L8CX_STATUS_OK))
+		{
+			(void)memcpy(&(p_dev->dci_shadow[offset]), data, data_size);
+			p_dev->dci_shadow_valid |= (uint16_t)1 << block;
+		}
 	}
 
+	VL53L8CX_StatsAdd(&(p_dev->platform), VL53L8CX_STATS_DCI_READ, stats_us,
+		data_size, status);
 	return status;
 }
 
@@ -1332,6 +2750,89 @@ uint8_t vl53l8cx_set_results_crc(
 	return status;
 }
 
+uint8_t vl53l8cx_set_outputs(
+		VL53L8CX_Configuration		*p_dev,
+		uint16_t			outputs)
+{
+	uint8_t status = VL53L8CX_STATUS_OK;
+
+	if((outputs & (uint16_t)~VL53L8CX_OUTPUTS_AVAILABLE) != (uint16_t)0)
+	{
+		status = VL53L8CX_STATUS_INVALID_PARAM;
+	}
+	else
+	{
+		p_dev->outputs = outputs;
+	}
+
+	return status;
+}
+
+uint8_t vl53l8cx_get_outputs(
+		VL53L8CX_Configuration		*p_dev,
+		uint16_t			*p_outputs)
+{
+	*p_outputs = p_dev->outputs;
+	return VL53L8CX_STATUS_OK;
+}
+
+uint8_t vl53l8cx_set_nb_target_per_zone(
+		VL53L8CX_Configuration		*p_dev,
+		uint8_t				nb_target_per_zone)
+{
+	uint8_t status = VL53L8CX_STATUS_OK;
+	uint8_t pipe_ctrl[] = {nb_target_per_zone, 0x00, 0x01, 0x00};
+	uint8_t tmp;
+
+	if((nb_target_per_zone < (uint8_t)1)
+		|| (nb_target_per_zone > (uint8_t)VL53L8CX_NB_TARGET_PER_ZONE))
+	{
+		status = VL53L8CX_STATUS_INVALID_PARAM;
+	}
+	else
+	{
+		status |= vl53l8cx_dci_write_data(p_dev, (uint8_t*)&pipe_ctrl,
+			VL53L8CX_DCI_PIPE_CONTROL, (uint16_t)sizeof(pipe_ctrl));
+
+		/* 2 targets per zone for the firmware with 1 target per zone */
+		tmp = (nb_target_per_zone == (uint8_t)1)
+			? (uint8_t)2 : nb_target_per_zone;
+		status |= vl53l8cx_dci_replace_data(p_dev, p_dev->temp_buffer,
+			VL53L8CX_DCI_FW_NB_TARGET, 16,
+			(uint8_t*)&tmp, 1, 0x0C);
+		p_dev->nb_target_per_zone = nb_target_per_zone;
+	}
+
+	return status;
+}
+
+uint8_t vl53l8cx_get_nb_target_per_zone(
+		VL53L8CX_Configuration		*p_dev,
+		uint8_t				*p_nb_target_per_zone)
+{
+	*p_nb_target_per_zone = p_dev->nb_target_per_zone;
+	return VL53L8CX_STATUS_OK;
+}
+
+uint8_t vl53l8cx_set_raw_format(
+		VL53L8CX_Configuration		*p_dev,
+		uint8_t				is_raw_format)
+{
+	/* The outputs of the view already converted are in the other format */
+	p_dev->is_raw_format = (is_raw_format != (uint8_t)0)
+		? (uint8_t)1 : (uint8_t)0;
+	p_dev->view.is_valid = (uint8_t)0;
+	return VL53L8CX_STATUS_OK;
+}
+
+uint8_t vl53l8cx_get_raw_format(
+		VL53L8CX_Configuration		*p_dev,
+		uint8_t				*p_is_raw_format)
+{
+	*p_is_raw_format = p_dev->is_raw_format;
+	return VL53L8CX_STATUS_OK;
+}
+
 
 uint8_t vl53l8cx_dci_write_data(
 		VL53L8CX_Configuration		*p_dev,
@@ -1341,6 +2842,8 @@ uint8_t vl53l8cx_dci_write_data(
 {
 	uint8_t status = VL53L8CX_STATUS_OK;
 	int16_t i;
+	int8_t block;
+	uint16_t offset = 0;
 
 	uint8_t headers[] = {0x00, 0x00, 0x00, 0x00};
 	uint8_t footer[] = {0x00, 0x00, 0x00, 0x0f, 0x05, 0x01,
@@ -1349,6 +2852,11 @@ uint8_t vl53l8cx_dci_write_data(
 
 	uint16_t address = (uint16_t)VL53L8CX_UI_CMD_END -
 		(data_size + (uint16_t)12) + (uint16_t)1;
+	uint64_t stats_us = VL53L8CX_StatsStart();
+
+	/* The temporary buffer may be overwritten */
+	p_dev->view.is_valid = (uint8_t)0;
+	block = _vl53l8cx_dci_shadow_find(index, data_size, &offset);
 
 	/* Check if cmd buffer is large enough */
 	if((data_size + (uint16_t)12) 
@@ -1356,8 +2864,22 @@ uint8_t vl53l8cx_dci_write_data(
 	{
 		status |= VL53L8CX_STATUS_ERROR;
 	}
+	else if((block >= (int8_t)0) && (p_dev->config_staging != (uint8_t)0))
+	{
+		/* Sent by vl53l8cx_commit_config() */
+		(void)memcpy(&(p_dev->dci_shadow[offset]), data, data_size);
+		p_dev->dci_shadow_valid |= (uint16_t)1 << block;
+		p_dev->dci_shadow_dirty |= (uint16_t)1 << block;
+	}
 	else
 	{
+		/* Keep the block before it is swapped, 'data' may be the
+		 * temporary buffer */
+		if(block >= (int8_t)0)
+		{
+			(void)memcpy(&(p_dev->dci_shadow[offset]), data, data_size);
+		}
+
 		headers[0] = (uint8_t)(index >> 8);
 		headers[1] = (uint8_t)(index & (uint32_t)0xff);
 		headers[2] = (uint8_t)(((data_size & (uint16_t)0xff0) >> 4));
@@ -1383,8 +2905,23 @@ uint8_t vl53l8cx_dci_write_data(
 			VL53L8CX_UI_CMD_STATUS, 0xff, 0x03);
 
 		VL53L8CX_SwapBuffer(data, data_size);
+
+		if(block >= (int8_t)0)
+		{
+			p_dev->dci_shadow_dirty &= ~((uint16_t)1 << block);
+			if(status == VL53L8CX_STATUS_OK)
+			{
+				p_dev->dci_shadow_valid |= (uint16_t)1 << block;
+			}
+			else
+			{
+				p_dev->dci_shadow_valid &= ~((uint16_t)1 << block);
+			}
+		}
 	}
 
+	VL53L8CX_StatsAdd(&(p_dev->platform), VL53L8CX_STATS_DCI_WRITE, stats_us,
+		data_size, status);
 	return status;
 }
 
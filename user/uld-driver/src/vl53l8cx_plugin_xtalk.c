@@ -23,25 +23,54 @@ static uint8_t _vl53l8cx_poll_for_answer(
 		uint8_t 				expected_value)
 {
 	uint8_t status = VL53L8CX_STATUS_OK;
-	uint8_t timeout = 0;
+	uint32_t interval_us = VL53L8CX_POLL_MIN_INTERVAL_US;
+	uint64_t start_us, elapsed_us;
 
+	start_us = VL53L8CX_GetTimeUs(&(p_dev->platform));
 	do {
 		status |= VL53L8CX_RdMulti(&(p_dev->platform), 
                                   address, p_dev->temp_buffer, 4);
-		status |= VL53L8CX_WaitMs(&(p_dev->platform), 10);
-		
-                /* 2s timeout or FW error*/
-		if((timeout >= (uint8_t)200) 
-                   || (p_dev->temp_buffer[2] >= (uint8_t) 0x7f))
+		elapsed_us = VL53L8CX_GetTimeUs(&(p_dev->platform)) - start_us;
+
+                /* FW error */
+		if(p_dev->temp_buffer[2] >= (uint8_t) 0x7f)
+		{
+			status |= VL53L8CX_MCU_ERROR;
+			break;
+		}
+
+		if((p_dev->temp_buffer[0x1]) == expected_value)
+		{
+			p_dev->last_answer_time_us = (uint32_t)elapsed_us;
+			if(p_dev->last_answer_time_us > p_dev->max_answer_time_us)
+			{
+				p_dev->max_answer_time_us = p_dev->last_answer_time_us;
+			}
+			break;
+		}
+
+                /* 2s timeout */
+		if(elapsed_us >= ((uint64_t)VL53L8CX_POLL_TIMEOUT_MS * 1000U))
 		{
 			status |= VL53L8CX_MCU_ERROR;
 			break;
 		}
-                else
-                {
-                  timeout++;
-                }
-	}while ((p_dev->temp_buffer[0x1]) != expected_value);
+
+		/* Device deadline */
+		if((p_dev->deadline_us != (uint64_t)0)
+			&& ((start_us + elapsed_us) >= p_dev->deadline_us))
+		{
+			status |= VL53L8CX_STATUS_TIMEOUT_ERROR;
+			break;
+		}
+
+		status |= VL53L8CX_WaitUs(&(p_dev->platform), interval_us);
+		interval_us *= (uint32_t)2;
+		if(interval_us > VL53L8CX_POLL_MAX_INTERVAL_US)
+		{
+			interval_us = VL53L8CX_POLL_MAX_INTERVAL_US;
+		}
+	}while(1);
         
 	return status;
 }
@@ -61,6 +90,7 @@ static uint8_t _vl53l8cx_program_output_config(
 
 	status |= vl53l8cx_get_resolution(p_dev, &resolution);
 	p_dev->data_read_size = 0;
+	p_dev->layout_nb_blocks = 0;
 
 	/* Enable mandatory output (meta and common data) */
 	uint32_t output_bh_enable[] = {
@@ -189,6 +219,7 @@ uint8_t vl53l8cx_calibrate_xtalk(
 		status |= VL53L8CX_WrMulti(&(p_dev->platform), 0x2c28,
 				p_dev->temp_buffer, 
                        (uint16_t)sizeof(VL53L8CX_CALIBRATE_XTALK));
+		vl53l8cx_dci_invalidate_shadow(p_dev);
 		status |= _vl53l8cx_poll_for_answer(p_dev,
 				VL53L8CX_UI_CMD_STATUS, 0x3);
 
@@ -243,6 +274,13 @@ uint8_t vl53l8cx_calibrate_xtalk(
 				status |= VL53L8CX_STATUS_ERROR;
 				continue_loop = (uint8_t)0;
 			}
+			else if((p_dev->deadline_us != (uint64_t)0)
+				&& (VL53L8CX_GetTimeUs(&(p_dev->platform))
+					>= p_dev->deadline_us))
+			{
+				status |= VL53L8CX_STATUS_TIMEOUT_ERROR;
+				continue_loop = (uint8_t)0;
+			}
 			else
 			{
 				timeout++;
@@ -267,11 +305,13 @@ uint8_t vl53l8cx_calibrate_xtalk(
 			VL53L8CX_XTALK_BUFFER_SIZE - (uint16_t)8);
 	(void)memcpy(&(p_dev->xtalk_data[VL53L8CX_XTALK_BUFFER_SIZE
                        - (uint16_t)8]), footer, sizeof(footer));
+	vl53l8cx_prepare_xtalk_data(p_dev);
 
 	/* Reset default buffer */
 	status |= VL53L8CX_WrMulti(&(p_dev->platform), 0x2c34,
 			p_dev->default_configuration,
 			VL53L8CX_CONFIGURATION_SIZE);
+	vl53l8cx_dci_invalidate_shadow(p_dev);
 	status |= _vl53l8cx_poll_for_answer(p_dev,VL53L8CX_UI_CMD_STATUS, 0x03);
 
 	/* Reset initial configuration */
@@ -282,6 +322,11 @@ uint8_t vl53l8cx_calibrate_xtalk(
 	status |= vl53l8cx_set_target_order(p_dev, target_order);
 	status |= vl53l8cx_set_xtalk_margin(p_dev, xtalk_margin);
 	status |= vl53l8cx_set_ranging_mode(p_dev, ranging_mode);
+	if(p_dev->nb_target_per_zone != (uint8_t)VL53L8CX_NB_TARGET_PER_ZONE)
+	{
+		status |= vl53l8cx_set_nb_target_per_zone(p_dev,
+				p_dev->nb_target_per_zone);
+	}
 
 	return status;
 }
@@ -323,6 +368,7 @@ uint8_t vl53l8cx_set_caldata_xtalk(
 
 	status |= vl53l8cx_get_resolution(p_dev, &resolution);
 	(void)memcpy(p_dev->xtalk_data, p_xtalk_data, VL53L8CX_XTALK_BUFFER_SIZE);
+	vl53l8cx_prepare_xtalk_data(p_dev);
 	status |= vl53l8cx_set_resolution(p_dev, resolution);
 
 	return status;